@@ -3,372 +3,2289 @@
 #include <string>
 #include <cmath>
 #include <utility>
-#include <unordered_map>
-#include <queue>
 #include <chrono>
+#include <cstdint>
+#include <array>
+#include <type_traits>
+#include <algorithm>
+#include <limits>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <sstream>
+#include <atomic>
+#include <unordered_map>
+#include <random>
+#include <sys/resource.h>
+#include <charconv>
+#include <system_error>
+
+// Goal cell of every tile, indexed by tile value (0 is the blank). The blank
+// belongs at cell input_i and the tiles fill the other cells in order.
+std::vector<int> getCorrectIndeces(std::size_t n, std::size_t input_i)
+{
+    std::vector<int> correctIndeces(n + 1, 0);
+
+    for (std::size_t i = 0; i < input_i; ++i)
+    {
+        correctIndeces[i + 1] = i;
+    }
+    correctIndeces[0] = input_i;
+    for (std::size_t i = input_i + 1; i <= n; ++i)
+    {
+        correctIndeces[i] = i;
+    }
+
+    return correctIndeces;
+}
+
+// Boards are packed 4 bits per tile up to 4x4 and 5 bits per tile for 5x5,
+// so every supported board fits into a 128-bit key.
+const std::size_t MAX_SIDE = 5;
+
+struct BoardKey
+{
+    std::uint64_t low = 0;
+    std::uint64_t high = 0;
+
+    bool operator == (const BoardKey& other) const
+    {
+        return this->low == other.low && this->high == other.high;
+    }
+
+    bool isEmpty() const
+    {
+        return this->low == 0 && this->high == 0;
+    }
+};
+
+struct BoardKeyHash
+{
+    std::size_t operator()(const BoardKey& key) const
+    {
+        std::uint64_t x = key.low ^ (key.high * 0x9e3779b97f4a7c15ULL);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+
+        return x;
+    }
+};
+
+template <std::size_t Side>
+class Board
+{
+    static_assert(Side >= 2 && Side <= MAX_SIDE, "Unsupported board size");
+
+public:
+    static const std::size_t CELLS = Side * Side;
+    static const std::size_t BITS_PER_TILE = (CELLS <= 16) ? 4 : 5;
+
+private:
+    std::array<std::uint8_t, CELLS> tiles;
+    std::uint8_t zeroIndex;
+
+public:
+    Board()
+        : tiles{}, zeroIndex(0) {}
+
+    explicit Board(const std::vector<std::vector<int>>& blocks)
+        : tiles{}, zeroIndex(0)
+    {
+        for (std::size_t i = 0; i < Side; ++i)
+        {
+            for (std::size_t j = 0; j < Side; ++j)
+            {
+                this->tiles[i * Side + j] = blocks[i][j];
+                if (blocks[i][j] == 0)
+                {
+                    this->zeroIndex = i * Side + j;
+                }
+            }
+        }
+    }
+
+    bool operator == (const Board& other) const
+    {
+        return this->tiles == other.tiles;
+    }
+
+    int at(std::size_t index) const
+    {
+        return this->tiles[index];
+    }
+
+    std::size_t getZeroIndex() const
+    {
+        return this->zeroIndex;
+    }
+
+    int getZeroX() const
+    {
+        return this->zeroIndex / Side;
+    }
+
+    int getZeroY() const
+    {
+        return this->zeroIndex % Side;
+    }
+
+    // Slides the tile at (newZeroX, newZeroY) into the blank.
+    void moveZero(int newZeroX, int newZeroY)
+    {
+        std::size_t newZeroIndex = newZeroX * Side + newZeroY;
+
+        this->tiles[this->zeroIndex] = this->tiles[newZeroIndex];
+        this->tiles[newZeroIndex] = 0;
+        this->zeroIndex = newZeroIndex;
+    }
+
+    BoardKey key() const
+    {
+        BoardKey key;
+        std::size_t offset = 0;
+
+        for (std::uint8_t tile : this->tiles)
+        {
+            std::uint64_t value = tile;
+
+            if (offset < 64)
+            {
+                key.low |= value << offset;
+                if (offset + BITS_PER_TILE > 64)
+                {
+                    key.high |= value >> (64 - offset);
+                }
+            }
+            else
+            {
+                key.high |= value << (offset - 64);
+            }
+
+            offset += BITS_PER_TILE;
+        }
+
+        return key;
+    }
+};
+
+static_assert(std::is_trivially_copyable<Board<MAX_SIDE>>::value, "Boards must be copyable without allocations");
 
-std::unordered_map<int, int> correctIndeces;
+// Search nodes live in a NodeArena and refer to their parent by index. The
+// parent index and the 2-bit move that produced the node share one word, so
+// the path is only rebuilt once a goal is found.
+const std::uint32_t NO_PARENT = (1u << 30) - 1;
+
+template <std::size_t Side>
 class BlocksState
 {
 private:
-    std::vector<std::vector<int>> blocks;
-    int manhattanDistance;
-    std::string road;
-    std::size_t level;
+    Board<Side> blocks;
+    std::uint16_t estimate;
+    std::uint16_t level;
+    std::uint32_t parentAndMove;
 
 public:
-    BlocksState(const std::vector<std::vector<int>>& blocks, int manhattanDistance, const std::string& road, std::size_t level)
-        : blocks(blocks), manhattanDistance(manhattanDistance), road(road), level(level) {}
+    BlocksState(const Board<Side>& blocks, int estimate, std::size_t level, std::uint32_t parent = NO_PARENT, int direction = 1)
+        : blocks(blocks), estimate(estimate), level(level), parentAndMove((parent << 2) | (direction - 1)) {}
 
     bool operator == (const BlocksState& other) const
     {
         return this->blocks == other.blocks;
     }
 
-    int getManhattanDistance() const
+    int getEstimate() const
     {
-        return this->manhattanDistance;
+        return this->estimate;
     }
 
-    const std::vector<std::vector<int>>& getBlocks() const 
+    const Board<Side>& getBlocks() const 
     {
         return this->blocks;
     }
 
-    const std::string& getRoad() const
+    std::size_t getLevel() const
     {
-        return this->road;
+        return this->level;
     }
 
-    const std::size_t getLevel() const
+    std::uint32_t getParent() const
     {
-        return this->level;
+        return this->parentAndMove >> 2;
+    }
+
+    int getDirection() const
+    {
+        return (this->parentAndMove & 3) + 1;
     }
 };
 
+template <std::size_t Side>
+using NodeArena = std::vector<BlocksState<Side>>;
+
+// Directions are numbered 1 to 4 (left, right, up, down) from the start state.
+template <std::size_t Side>
+std::vector<int> getRoad(const NodeArena<Side>& arena, std::uint32_t index)
+{
+    std::vector<int> road;
+
+    while (arena[index].getParent() != NO_PARENT)
+    {
+        road.push_back(arena[index].getDirection());
+        index = arena[index].getParent();
+    }
+
+    std::reverse(road.begin(), road.end());
+
+    return road;
+}
+
 struct Node
 {
-    BlocksState* value;
-    Node* next;
+    std::uint32_t index;
+    std::uint32_t cost;
 
-    Node(BlocksState* value, Node* next = nullptr)
-        : value(value), next(next) {}
+    Node(std::uint32_t index, std::uint32_t cost)
+        : index(index), cost(cost) {}
 };
 
 struct CompareBlocksState
 {
-    bool operator()(const Node* lhs, const Node* rhs) const
+    bool operator()(const Node& lhs, const Node& rhs) const
     {
-        return lhs->value->getManhattanDistance() + lhs->value->getLevel() > rhs->value->getManhattanDistance() + rhs->value->getLevel();
+        return lhs.cost > rhs.cost;
     }
 };
 
+// Binary heap kept in a plain vector (as std::priority_queue does) so that
+// its capacity can be reported.
 class PriorityQueue
 {
 private:
-    std::priority_queue<Node*, std::vector<Node*>, CompareBlocksState> queue;
+    std::vector<Node> heap;
 
 public:
-    PriorityQueue(BlocksState* initialState)
+    PriorityQueue(std::uint32_t initialIndex, std::uint32_t initialCost)
     {
-        queue.push(new Node(initialState));
+        push(initialIndex, initialCost, 0);
     }
 
-    Node* pop()
+    bool empty() const
     {
-        if (queue.empty())
-        {
-            return nullptr;
-        }
+        return heap.empty();
+    }
 
-        Node* result = queue.top();
-        queue.pop();
+    Node pop()
+    {
+        std::pop_heap(heap.begin(), heap.end(), CompareBlocksState());
+        Node result = heap.back();
+        heap.pop_back();
 
         return result;
     }
 
     std::size_t size() const
     {
-        return queue.size();
+        return heap.size();
     }
 
-    void push(BlocksState* newState)
+    void push(std::uint32_t index, std::uint32_t cost, std::uint32_t)
     {
-        queue.push(new Node(newState));
+        heap.push_back(Node(index, cost));
+        std::push_heap(heap.begin(), heap.end(), CompareBlocksState());
     }
 
-    ~PriorityQueue()
+    std::size_t getMemoryBytes() const
     {
-        while (!queue.empty())
-        {
-            Node* top = queue.top();
-            queue.pop();
-            delete top;  
-        }
+        return heap.capacity() * sizeof(Node);
     }
 };
 
-int getManhattanDistance(const std::vector<std::vector<int>>& blocks)
+// Open list for small integer costs: one bucket per f and, inside it, one
+// stack per g. pop() takes the most recent node of the deepest level among
+// the cheapest ones, so ties on f are broken towards the goal.
+class BucketQueue
 {
-    int result = 0;
+private:
+    std::vector<std::vector<std::vector<std::uint32_t>>> buckets;
+    std::vector<std::uint32_t> maxLevels;
+    std::uint32_t minCost;
+    std::size_t count;
 
-    for (int i = 0; i < blocks.size(); ++i)
+    // Moves minCost and the deepest level of its bucket to the next node.
+    void advance()
     {
-        for (int j = 0; j < blocks.size(); ++j)
+        while (true)
         {
-            int blockValue = blocks[i][j];
-
-            if (blockValue == 0)
+            if (!this->buckets[this->minCost].empty())
             {
-                continue;
-            }
+                std::vector<std::vector<std::uint32_t>>& bucket = this->buckets[this->minCost];
+                std::uint32_t& maxLevel = this->maxLevels[this->minCost];
+
+                // Levels below the deepest non-empty one are scanned lazily.
+                while (maxLevel > 0 && bucket[maxLevel].empty())
+                {
+                    --maxLevel;
+                }
 
-            int targetX = correctIndeces[blockValue] / blocks.size();
-            int targetY = correctIndeces[blockValue] % blocks.size();
+                if (!bucket[maxLevel].empty())
+                {
+                    break;
+                }
+            }
 
-            result += (std::abs(i - targetX) + std::abs(j - targetY));
+            ++this->minCost;
         }
     }
 
-    return result;
-}
+public:
+    BucketQueue()
+        : minCost(std::numeric_limits<std::uint32_t>::max()), count(0) {}
 
-std::pair<int, int> getZeroCoordinates(const std::vector<std::vector<int>> blocks)
-{
-    for (std::size_t i = 0; i < blocks.size(); ++i)
+    BucketQueue(std::uint32_t initialIndex, std::uint32_t initialCost)
+        : minCost(initialCost), count(0)
     {
-        for (std::size_t j = 0; j < blocks[0].size(); ++j)
-        {
-            if (blocks[i][j] == 0)
-            {
-                return std::make_pair(i, j);
-            }
-        }
+        push(initialIndex, initialCost, 0);
     }
 
-    return std::make_pair(-1, -1);
-}
+    bool empty() const
+    {
+        return this->count == 0;
+    }
 
-BlocksState* createBlocksState(const std::vector<std::vector<int>>& blocks, int zeroX, int zeroY, int newZeroX, int newZeroY, const std::string& road, std::size_t level)
-{
-    if (newZeroX < 0 || newZeroX >= blocks.size() || newZeroY < 0 || newZeroY >= blocks[0].size())
+    // The smallest f in a non-empty queue.
+    std::uint32_t getMinCost()
     {
-        return nullptr;
+        advance();
+
+        return this->minCost;
     }
 
-    std::vector<std::vector<int>> newBlocks = blocks;
-    newBlocks[zeroX][zeroY] = newBlocks[newZeroX][newZeroY];
-    newBlocks[newZeroX][newZeroY] = 0;
+    Node pop()
+    {
+        advance();
 
-    return new BlocksState(newBlocks, getManhattanDistance(newBlocks), road, level + 1);
-}
+        std::vector<std::uint32_t>& stack = this->buckets[this->minCost][this->maxLevels[this->minCost]];
+        Node result(stack.back(), this->minCost);
+        stack.pop_back();
+        --this->count;
 
-bool contains(const std::vector<BlocksState*>& states, BlocksState* state)
-{
-    for (auto current : states)
+        return result;
+    }
+
+    std::size_t size() const
     {
-        if (current->getBlocks() == state->getBlocks())
+        return this->count;
+    }
+
+    void push(std::uint32_t index, std::uint32_t cost, std::uint32_t level)
+    {
+        if (cost >= this->buckets.size())
         {
-            return true;
+            this->buckets.resize(cost + 1);
+            this->maxLevels.resize(cost + 1, 0);
         }
-    }
 
-    return false;
-}
+        std::vector<std::vector<std::uint32_t>>& bucket = this->buckets[cost];
+        if (level >= bucket.size())
+        {
+            bucket.resize(level + 1);
+        }
 
-int getInversionsCount(const std::vector<std::vector<int>>& blocks)
-{
-    std::vector<int> arr;
+        bucket[level].push_back(index);
+        this->maxLevels[cost] = std::max(this->maxLevels[cost], level);
+        this->minCost = std::min(this->minCost, cost);
+        ++this->count;
+    }
 
-    for (auto row : blocks)
+    std::size_t getMemoryBytes() const
     {
-        for (auto element : row)
+        std::size_t bytes = this->buckets.capacity() * sizeof(this->buckets[0]) +
+                            this->maxLevels.capacity() * sizeof(std::uint32_t);
+
+        for (const std::vector<std::vector<std::uint32_t>>& bucket : this->buckets)
         {
-            arr.push_back(element);
+            bytes += bucket.capacity() * sizeof(bucket[0]);
+            for (const std::vector<std::uint32_t>& stack : bucket)
+            {
+                bytes += stack.capacity() * sizeof(std::uint32_t);
+            }
         }
+
+        return bytes;
     }
+};
 
-    int inversionsCount = 0;
-    for (std::size_t i = 0; i < arr.size() - 1; ++i)
+// Manhattan distance of every tile from every cell, precomputed from
+// correctIndeces so that a move updates the heuristic with two lookups.
+template <std::size_t Side>
+class ManhattanTable
+{
+private:
+    static const std::size_t CELLS = Board<Side>::CELLS;
+
+    std::array<std::uint8_t, CELLS * CELLS> distances;
+
+public:
+    explicit ManhattanTable(const std::vector<int>& correctIndeces)
+        : distances{}
     {
-        for (std::size_t j = i + 1; j < arr.size(); ++j)
+        for (std::size_t tile = 1; tile < CELLS; ++tile)
         {
-            if (arr[j] && arr[i] &&  arr[i] > arr[j])
+            int targetX = correctIndeces[tile] / Side;
+            int targetY = correctIndeces[tile] % Side;
+
+            for (std::size_t cell = 0; cell < CELLS; ++cell)
             {
-                ++inversionsCount;
+                int x = cell / Side;
+                int y = cell % Side;
+
+                this->distances[tile * CELLS + cell] = std::abs(x - targetX) + std::abs(y - targetY);
             }
         }
     }
-    return inversionsCount;
-}
 
-bool isSolvable(const std::vector<std::vector<int>>& blocks, int zeroRowIndex)
+    int get(int tile, std::size_t cell) const
+    {
+        return this->distances[tile * CELLS + cell];
+    }
+
+    // Change of the heuristic when the blank moves to newZeroIndex and the
+    // tile that was there slides into oldZeroIndex.
+    int getDelta(const Board<Side>& blocks, std::size_t newZeroIndex) const
+    {
+        int tile = blocks.at(newZeroIndex);
+        std::size_t oldZeroIndex = blocks.getZeroIndex();
+
+        return get(tile, oldZeroIndex) - get(tile, newZeroIndex);
+    }
+};
+
+template <std::size_t Side>
+int getManhattanDistance(const Board<Side>& blocks, const ManhattanTable<Side>& table)
 {
-    int inversionsCount = getInversionsCount(blocks);
- 
-    if (blocks.size() % 2 == 1)
+    int result = 0;
+
+    for (std::size_t cell = 0; cell < Board<Side>::CELLS; ++cell)
     {
-        return (inversionsCount % 2 == 0);
+        result += table.get(blocks.at(cell), cell);
     }
 
-    return ((inversionsCount + zeroRowIndex) % 2 == 1);
+    return result;
 }
 
+// Disjoint additive pattern databases. Every tile except the blank belongs to
+// exactly one pattern, and each table stores how many moves of its own tiles
+// are needed to bring them home when any cell outside the pattern may be used
+// as the blank. The values of different patterns can therefore be summed.
+//
+// File layout: "PDB1", side, pattern count, the goal cell of every tile, the
+// pattern of every tile (NO_PATTERN for the blank), then one byte per
+// placement for each pattern table in order.
+const std::uint8_t NO_PATTERN = 0xff;
+const char PDB_MAGIC[4] = {'P', 'D', 'B', '1'};
 
-BlocksState* solve(PriorityQueue& queue, std::vector<BlocksState*>& visited)
+// 4-4 for 3x3, 6-6-3 for 4x4 and 6-6-6-6 for 5x5, grouped by tile number.
+std::vector<std::size_t> getPatternSizes(std::size_t side)
 {
-    Node* currentState = queue.pop();
-
-    while (currentState)
+    switch (side)
     {
-        std::pair<int, int> zeroCoordinates = getZeroCoordinates(currentState->value->getBlocks());
-        int zeroX = zeroCoordinates.first;
-        int zeroY = zeroCoordinates.second;
+    case 3:
+        return {4, 4};
+    case 4:
+        return {6, 6, 3};
+    case 5:
+        return {6, 6, 6, 6};
+    default:
+        return {};
+    }
+}
+
+template <std::size_t Side>
+class PatternDatabase
+{
+private:
+    static const std::size_t CELLS = Board<Side>::CELLS;
+    static const std::size_t HEADER_SIZE = sizeof(PDB_MAGIC) + 2 + 2 * CELLS;
 
-        std::vector<std::pair<int, int>> moves;
-        moves.push_back(std::make_pair(zeroX, zeroY + 1));
-        moves.push_back(std::make_pair(zeroX, zeroY - 1));
-        moves.push_back(std::make_pair(zeroX + 1, zeroY));
-        moves.push_back(std::make_pair(zeroX - 1, zeroY));
+    std::array<std::uint8_t, CELLS> goal;
+    std::array<std::uint8_t, CELLS> patternOf;
+    std::vector<std::vector<std::uint8_t>> patternTiles;
+    std::vector<const std::uint8_t*> tables;
 
-        int direction = 0;
+    void* mapping;
+    std::size_t mappingSize;
+
+    static std::size_t getTableSize(std::size_t tilesCount)
+    {
+        std::size_t size = 1;
 
-        for (auto move : moves)
+        for (std::size_t i = 0; i < tilesCount; ++i)
         {
-            ++direction;
-            std::string road = currentState->value->getRoad() + std::to_string(direction);
+            size *= CELLS - i;
+        }
 
-            BlocksState* newBlocksState = createBlocksState(currentState->value->getBlocks(), zeroX, zeroY, move.first, move.second, road, currentState->value->getLevel());
+        return size;
+    }
 
-            if (newBlocksState)
-            {
-                if (newBlocksState->getManhattanDistance() == 0)
-                {
-                    return newBlocksState;
-                }
+    // Index of an ordered placement of distinct cells among all
+    // CELLS! / (CELLS - k)! placements.
+    static std::size_t rank(const std::uint8_t* positions, std::size_t tilesCount)
+    {
+        std::size_t index = 0;
+        std::uint32_t used = 0;
 
-                if (!contains(visited, newBlocksState))
-                {
-                    queue.push(newBlocksState);
-                    visited.push_back(newBlocksState);
-                }
-                else
-                {
-                    delete newBlocksState;
-                }
-            }
+        for (std::size_t i = 0; i < tilesCount; ++i)
+        {
+            std::uint32_t position = positions[i];
+            std::size_t smallerUsed = __builtin_popcount(used & ((1u << position) - 1));
+
+            index = index * (CELLS - i) + (position - smallerUsed);
+            used |= 1u << position;
         }
 
-        delete currentState;
-        currentState = queue.pop();
+        return index;
     }
 
-    return nullptr;
-}
+    static void unrank(std::size_t index, std::uint8_t* positions, std::size_t tilesCount)
+    {
+        std::size_t digits[CELLS];
 
-int main ()
-{
-    std::size_t n;
-    std::cin >> n;
-    std::size_t side = std::sqrt(n + 1);
-    std::vector<std::vector<int>> blocks(side, std::vector<int>(side));
+        for (std::size_t i = tilesCount; i-- > 0;)
+        {
+            digits[i] = index % (CELLS - i);
+            index /= (CELLS - i);
+        }
 
-    int input_i;
-    std::cin >> input_i;
+        std::uint32_t used = 0;
 
-    // auto start = std::chrono::high_resolution_clock::now();
+        for (std::size_t i = 0; i < tilesCount; ++i)
+        {
+            std::size_t skip = digits[i];
+            std::uint8_t cell = 0;
 
-    input_i = (input_i == -1) ? n : input_i;
+            while ((used & (1u << cell)) || skip-- > 0)
+            {
+                ++cell;
+            }
 
-    for (std::size_t i = 0; i < input_i; ++i)
-    {
-        correctIndeces.insert(std::make_pair(i + 1, i));
-    }
-    correctIndeces.insert(std::make_pair(0, input_i));
-    for (std::size_t i = input_i + 1; i <= n; ++i)
-    {
-        correctIndeces.insert(std::make_pair(i, i));
+            positions[i] = cell;
+            used |= 1u << cell;
+        }
     }
 
-    int zeroRowIndex = 0;
-
-    for (std::size_t k = 0; k < side; ++k)
+    void assignPatterns(const std::vector<std::size_t>& patternSizes)
     {
-        for (std::size_t j = 0; j < side; ++j)
+        this->patternOf.fill(NO_PATTERN);
+        this->patternTiles.assign(patternSizes.size(), {});
+
+        std::size_t tile = 1;
+        for (std::size_t pattern = 0; pattern < patternSizes.size(); ++pattern)
         {
-            std::cin >> blocks[k][j];
-            if (blocks[k][j] == 0)
+            for (std::size_t i = 0; i < patternSizes[pattern]; ++i, ++tile)
             {
-                zeroRowIndex = k;
+                this->patternOf[tile] = pattern;
+                this->patternTiles[pattern].push_back(tile);
             }
         }
     }
 
-    BlocksState* initialState = new BlocksState(blocks, getManhattanDistance(blocks), "", 0);
-
-    if (!isSolvable(initialState->getBlocks(), zeroRowIndex))
+    std::size_t getIndex(std::size_t pattern, const std::array<std::uint8_t, CELLS>& tilePositions) const
     {
-        std::cout << -1 << std::endl;
-        // auto end = std::chrono::high_resolution_clock::now();
-        // auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-        // std::cout << "Program executed for " << duration.count() << " milliseconds (" << duration.count() / 1000.0 <<  " seconds)" << std::endl;
+        std::uint8_t positions[CELLS];
+        const std::vector<std::uint8_t>& tiles = this->patternTiles[pattern];
+
+        for (std::size_t i = 0; i < tiles.size(); ++i)
+        {
+            positions[i] = tilePositions[tiles[i]];
+        }
+
+        return rank(positions, tiles.size());
     }
-    else if (initialState->getManhattanDistance() == 0)
+
+    static std::array<std::uint8_t, CELLS> getTilePositions(const Board<Side>& blocks)
     {
-        std::cout << 0 << std::endl;
-        // auto end = std::chrono::high_resolution_clock::now();
-        // auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-        // std::cout << "Program executed for " << duration.count() << " milliseconds (" << duration.count() / 1000.0 <<  " seconds)" << std::endl;
+        std::array<std::uint8_t, CELLS> tilePositions;
+
+        for (std::size_t cell = 0; cell < CELLS; ++cell)
+        {
+            tilePositions[blocks.at(cell)] = cell;
+        }
+
+        return tilePositions;
     }
-    else
+
+    static std::vector<std::uint8_t> buildTable(const std::vector<std::uint8_t>& goalPositions)
     {
-        PriorityQueue queue(initialState);
-        std::vector<BlocksState*> visited;
+        const std::uint8_t UNKNOWN = 0xff;
+        const int side = static_cast<int>(Side);
+        std::size_t tilesCount = goalPositions.size();
+        std::vector<std::uint8_t> table(getTableSize(tilesCount), UNKNOWN);
 
-        BlocksState* solution  = solve(queue, visited);
+        table[rank(goalPositions.data(), tilesCount)] = 0;
 
-        if (solution)
+        // Breadth-first search by repeated sweeps over the table, so that no
+        // frontier queue has to be kept next to it.
+        bool changed = true;
+        for (std::uint8_t depth = 0; changed; ++depth)
         {
-            // auto end = std::chrono::high_resolution_clock::now();
-            // auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-            // std::cout << "Program executed for " << duration.count() << " milliseconds (" << duration.count() / 1000.0 <<  " seconds)" << std::endl;
-            std::cout << solution->getRoad().length() << std::endl;
+            changed = false;
 
-            for (char ch : solution->getRoad())
+            for (std::size_t index = 0; index < table.size(); ++index)
             {
-                switch (ch)
+                if (table[index] != depth)
                 {
-                case '1':
-                    std::cout << "left" << std::endl;
-                    break;
-                case '2':
-                    std::cout << "right" << std::endl;
-                    break;
-                case '3':
-                    std::cout << "up" << std::endl;
-                    break;
-                case '4':
-                    std::cout << "down" << std::endl;
-                    break;
-                default:
-                    break;
+                    continue;
                 }
-            }
 
-            delete solution;
-        }
-        else
-        {
-            std::cout << -1 << std::endl;
-        }
+                std::uint8_t positions[CELLS];
+                unrank(index, positions, tilesCount);
 
-        for (BlocksState* state : visited)
-        {
-            delete state;
-        }
-    }
+                std::uint32_t occupied = 0;
+                for (std::size_t i = 0; i < tilesCount; ++i)
+                {
+                    occupied |= 1u << positions[i];
+                }
+
+                for (std::size_t i = 0; i < tilesCount; ++i)
+                {
+                    int x = positions[i] / Side;
+                    int y = positions[i] % Side;
+                    std::pair<int, int> moves[] = {
+                        std::make_pair(x, y + 1),
+                        std::make_pair(x, y - 1),
+                        std::make_pair(x + 1, y),
+                        std::make_pair(x - 1, y)
+                    };
+
+                    std::uint8_t oldPosition = positions[i];
+
+                    for (auto move : moves)
+                    {
+                        if (move.first < 0 || move.first >= side || move.second < 0 || move.second >= side)
+                        {
+                            continue;
+                        }
+
+                        std::uint8_t newPosition = move.first * Side + move.second;
+                        if (occupied & (1u << newPosition))
+                        {
+                            continue;
+                        }
+
+                        positions[i] = newPosition;
+                        std::size_t newIndex = rank(positions, tilesCount);
+                        if (table[newIndex] == UNKNOWN)
+                        {
+                            table[newIndex] = depth + 1;
+                            changed = true;
+                        }
+                    }
+
+                    positions[i] = oldPosition;
+                }
+            }
+        }
+
+        return table;
+    }
+
+public:
+    PatternDatabase()
+        : goal{}, patternOf{}, mapping(nullptr), mappingSize(0) {}
+
+    PatternDatabase(const PatternDatabase&) = delete;
+    PatternDatabase& operator = (const PatternDatabase&) = delete;
+
+    ~PatternDatabase()
+    {
+        if (this->mapping)
+        {
+            munmap(this->mapping, this->mappingSize);
+        }
+    }
+
+    static bool generate(const std::string& path, const std::vector<int>& correctIndeces)
+    {
+        PatternDatabase database;
+        database.assignPatterns(getPatternSizes(Side));
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        file.write(PDB_MAGIC, sizeof(PDB_MAGIC));
+        file.put(Side);
+        file.put(database.patternTiles.size());
+        for (std::size_t tile = 0; tile < CELLS; ++tile)
+        {
+            file.put(correctIndeces[tile]);
+        }
+        file.write(reinterpret_cast<const char*>(database.patternOf.data()), CELLS);
+
+        for (const std::vector<std::uint8_t>& tiles : database.patternTiles)
+        {
+            std::vector<std::uint8_t> goalPositions;
+            for (std::uint8_t tile : tiles)
+            {
+                goalPositions.push_back(correctIndeces[tile]);
+            }
+
+            std::vector<std::uint8_t> table = buildTable(goalPositions);
+            file.write(reinterpret_cast<const char*>(table.data()), table.size());
+        }
+
+        return static_cast<bool>(file);
+    }
+
+    // Maps the file read-only. Fails if it was generated for another board
+    // size or goal layout.
+    bool load(const std::string& path, const std::vector<int>& correctIndeces)
+    {
+        int descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+        {
+            return false;
+        }
+
+        struct stat status;
+        if (fstat(descriptor, &status) != 0 || static_cast<std::size_t>(status.st_size) < HEADER_SIZE)
+        {
+            close(descriptor);
+            return false;
+        }
+
+        std::size_t size = status.st_size;
+        void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0);
+        close(descriptor);
+
+        if (address == MAP_FAILED)
+        {
+            return false;
+        }
+
+        const std::uint8_t* data = static_cast<const std::uint8_t*>(address);
+        const std::uint8_t* goal = data + sizeof(PDB_MAGIC) + 2;
+        const std::uint8_t* patterns = goal + CELLS;
+
+        bool valid = std::equal(PDB_MAGIC, PDB_MAGIC + sizeof(PDB_MAGIC), data) && data[4] == Side;
+        for (std::size_t tile = 0; valid && tile < CELLS; ++tile)
+        {
+            valid = (goal[tile] == correctIndeces[tile]);
+        }
+
+        std::size_t patternsCount = data[5];
+        std::vector<std::vector<std::uint8_t>> patternTiles(valid ? patternsCount : 0);
+        for (std::size_t tile = 0; valid && tile < CELLS; ++tile)
+        {
+            if (patterns[tile] < patternsCount)
+            {
+                patternTiles[patterns[tile]].push_back(tile);
+            }
+            else
+            {
+                valid = (patterns[tile] == NO_PATTERN && tile == 0);
+            }
+        }
+
+        std::vector<const std::uint8_t*> tables;
+        std::size_t offset = HEADER_SIZE;
+        for (std::size_t pattern = 0; valid && pattern < patternsCount; ++pattern)
+        {
+            tables.push_back(data + offset);
+            offset += getTableSize(patternTiles[pattern].size());
+        }
+
+        if (!valid || offset != size)
+        {
+            munmap(address, size);
+            return false;
+        }
+
+        std::copy(goal, goal + CELLS, this->goal.begin());
+        std::copy(patterns, patterns + CELLS, this->patternOf.begin());
+        this->patternTiles = std::move(patternTiles);
+        this->tables = std::move(tables);
+        this->mapping = address;
+        this->mappingSize = size;
+
+        return true;
+    }
+
+    bool isLoaded() const
+    {
+        return this->mapping != nullptr;
+    }
+
+    bool matches(const std::vector<int>& correctIndeces) const
+    {
+        return std::equal(this->goal.begin(), this->goal.end(), correctIndeces.begin());
+    }
+
+    int getDistance(const Board<Side>& blocks) const
+    {
+        std::array<std::uint8_t, CELLS> tilePositions = getTilePositions(blocks);
+        int result = 0;
+
+        for (std::size_t pattern = 0; pattern < this->tables.size(); ++pattern)
+        {
+            result += this->tables[pattern][getIndex(pattern, tilePositions)];
+        }
+
+        return result;
+    }
+
+    // Only the pattern of the tile that slides into the blank changes.
+    int getDelta(const Board<Side>& blocks, std::size_t newZeroIndex) const
+    {
+        int tile = blocks.at(newZeroIndex);
+        std::size_t pattern = this->patternOf[tile];
+        std::array<std::uint8_t, CELLS> tilePositions = getTilePositions(blocks);
+
+        int before = this->tables[pattern][getIndex(pattern, tilePositions)];
+        tilePositions[tile] = blocks.getZeroIndex();
+        int after = this->tables[pattern][getIndex(pattern, tilePositions)];
+
+        return after - before;
+    }
+};
+
+// The estimate used by every search mode: the pattern databases when they
+// were loaded for this board, the Manhattan distance otherwise.
+template <std::size_t Side>
+class Heuristic
+{
+private:
+    ManhattanTable<Side> manhattan;
+    const PatternDatabase<Side>* patterns;
+
+public:
+    Heuristic(const std::vector<int>& correctIndeces, const PatternDatabase<Side>* patterns = nullptr)
+        : manhattan(correctIndeces), patterns(patterns) {}
+
+    int getDistance(const Board<Side>& blocks) const
+    {
+        return this->patterns ? this->patterns->getDistance(blocks) : getManhattanDistance(blocks, this->manhattan);
+    }
+
+    int getDelta(const Board<Side>& blocks, std::size_t newZeroIndex) const
+    {
+        return this->patterns ? this->patterns->getDelta(blocks, newZeroIndex) : this->manhattan.getDelta(blocks, newZeroIndex);
+    }
+};
+
+// Where the blank can go next, in direction order 1 to 4. Moves off the board
+// are rejected by createBlocksState.
+template <std::size_t Side>
+std::array<std::pair<int, int>, 4> getZeroMoves(const Board<Side>& blocks)
+{
+    int zeroX = blocks.getZeroX();
+    int zeroY = blocks.getZeroY();
+
+    return {
+        std::make_pair(zeroX, zeroY + 1),
+        std::make_pair(zeroX, zeroY - 1),
+        std::make_pair(zeroX + 1, zeroY),
+        std::make_pair(zeroX - 1, zeroY)
+    };
+}
+
+template <std::size_t Side>
+bool createBlocksState(const Board<Side>& blocks, int newZeroX, int newZeroY, Board<Side>& newBlocks)
+{
+    const int side = static_cast<int>(Side);
+
+    if (newZeroX < 0 || newZeroX >= side || newZeroY < 0 || newZeroY >= side)
+    {
+        return false;
+    }
+
+    newBlocks = blocks;
+    newBlocks.moveZero(newZeroX, newZeroY);
+
+    return true;
+}
+
+// Open-addressing (linear probing) set of packed boards. The all-zero key can
+// never be produced by a real board, so it marks an empty slot.
+class ClosedSet
+{
+private:
+    std::vector<BoardKey> slots;
+    std::size_t count;
+
+    static std::size_t hash(const BoardKey& key)
+    {
+        return BoardKeyHash()(key);
+    }
+
+    void grow()
+    {
+        std::vector<BoardKey> oldSlots(this->slots.size() * 2);
+        oldSlots.swap(this->slots);
+
+        for (const BoardKey& key : oldSlots)
+        {
+            if (!key.isEmpty())
+            {
+                std::size_t mask = this->slots.size() - 1;
+                std::size_t index = hash(key) & mask;
+                while (!this->slots[index].isEmpty())
+                {
+                    index = (index + 1) & mask;
+                }
+                this->slots[index] = key;
+            }
+        }
+    }
+
+public:
+    ClosedSet(std::size_t initialCapacity = 1 << 16)
+        : slots(initialCapacity), count(0) {}
+
+    // Returns false if the key was already present.
+    bool insert(const BoardKey& key)
+    {
+        if ((this->count + 1) * 10 > this->slots.size() * 7)
+        {
+            grow();
+        }
+
+        std::size_t mask = this->slots.size() - 1;
+        std::size_t index = hash(key) & mask;
+
+        while (!this->slots[index].isEmpty())
+        {
+            if (this->slots[index] == key)
+            {
+                return false;
+            }
+            index = (index + 1) & mask;
+        }
+
+        this->slots[index] = key;
+        ++this->count;
+
+        return true;
+    }
+
+    std::size_t size() const
+    {
+        return this->count;
+    }
+
+    std::size_t getMemoryBytes() const
+    {
+        return this->slots.capacity() * sizeof(BoardKey);
+    }
+};
+
+int getInversionsCount(const std::vector<std::vector<int>>& blocks)
+{
+    std::vector<int> arr;
+
+    for (auto row : blocks)
+    {
+        for (auto element : row)
+        {
+            arr.push_back(element);
+        }
+    }
+
+    int inversionsCount = 0;
+    for (std::size_t i = 0; i < arr.size() - 1; ++i)
+    {
+        for (std::size_t j = i + 1; j < arr.size(); ++j)
+        {
+            if (arr[j] && arr[i] &&  arr[i] > arr[j])
+            {
+                ++inversionsCount;
+            }
+        }
+    }
+    return inversionsCount;
+}
+
+bool isSolvable(const std::vector<std::vector<int>>& blocks, int zeroRowIndex)
+{
+    int inversionsCount = getInversionsCount(blocks);
+ 
+    if (blocks.size() % 2 == 1)
+    {
+        return (inversionsCount % 2 == 0);
+    }
+
+    return ((inversionsCount + zeroRowIndex) % 2 == 1);
+}
+
+
+// Counters filled in by every search mode. Peak open is the deepest path for
+// IDA*; duplicates are the states already seen (A*, HDA*) or the moves that
+// would undo the previous one (IDA*). Search memory is what the arena, closed
+// set and open list hold when the search ends; none of them ever shrink, so
+// it is also their peak. It does not depend on earlier searches in the same
+// process, unlike the process peak.
+struct SearchStats
+{
+    std::uint64_t expanded = 0;
+    std::uint64_t generated = 0;
+    std::uint64_t duplicates = 0;
+    std::size_t peakOpen = 0;
+    std::size_t peakClosed = 0;
+    std::size_t memoryBytes = 0;
+    double seconds = 0;
+    double firstSolutionSeconds = -1;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    double getElapsedSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start).count();
+    }
+
+    void recordSolution()
+    {
+        if (this->firstSolutionSeconds < 0)
+        {
+            this->firstSolutionSeconds = getElapsedSeconds();
+        }
+    }
+
+    double getNodesPerSecond() const
+    {
+        return (this->seconds > 0) ? this->expanded / this->seconds : 0;
+    }
+};
+
+// Peak resident set size of the whole process in kilobytes. It covers every
+// search run so far (and the pattern databases), so it only ever grows.
+long getPeakMemory()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss;
+}
+
+template <std::size_t Side, typename OpenList>
+std::uint32_t solve(OpenList& queue, ClosedSet& visited, NodeArena<Side>& arena, const Heuristic<Side>& heuristic, SearchStats& stats)
+{
+    while (!queue.empty())
+    {
+        stats.peakOpen = std::max(stats.peakOpen, queue.size());
+        ++stats.expanded;
+
+        std::uint32_t currentIndex = queue.pop().index;
+        // Copied because pushing children may reallocate the arena.
+        BlocksState<Side> currentState = arena[currentIndex];
+
+        int direction = 0;
+
+        for (auto move : getZeroMoves(currentState.getBlocks()))
+        {
+            ++direction;
+
+            Board<Side> newBlocks;
+
+            if (createBlocksState(currentState.getBlocks(), move.first, move.second, newBlocks))
+            {
+                ++stats.generated;
+
+                int estimate = currentState.getEstimate() + heuristic.getDelta(currentState.getBlocks(), move.first * Side + move.second);
+                std::size_t level = currentState.getLevel() + 1;
+
+                if (estimate == 0)
+                {
+                    stats.recordSolution();
+                    stats.peakClosed = visited.size();
+                    arena.emplace_back(newBlocks, estimate, level, currentIndex, direction);
+                    return arena.size() - 1;
+                }
+
+                if (visited.insert(newBlocks.key()))
+                {
+                    arena.emplace_back(newBlocks, estimate, level, currentIndex, direction);
+                    queue.push(arena.size() - 1, estimate + level, level);
+                }
+                else
+                {
+                    ++stats.duplicates;
+                }
+            }
+        }
+    }
+
+    stats.peakClosed = visited.size();
+
+    return NO_PARENT;
+}
+
+const int FOUND = -1;
+
+int getOppositeDirection(int direction)
+{
+    return (direction % 2 == 1) ? direction + 1 : direction - 1;
+}
+
+// One depth-first iteration of IDA*. The board is modified in place and every
+// move is undone on the way back, so memory stays linear in the depth.
+template <std::size_t Side>
+int idaSearch(Board<Side>& blocks, int estimate, std::size_t level, int bound, int previousDirection,
+              std::vector<int>& road, const Heuristic<Side>& heuristic, SearchStats& stats)
+{
+    int cost = level + estimate;
+
+    if (cost > bound)
+    {
+        return cost;
+    }
+
+    if (estimate == 0)
+    {
+        stats.recordSolution();
+        return FOUND;
+    }
+
+    ++stats.expanded;
+    stats.peakOpen = std::max(stats.peakOpen, level + 1);
+
+    const int side = static_cast<int>(Side);
+    int zeroX = blocks.getZeroX();
+    int zeroY = blocks.getZeroY();
+
+    int minimum = std::numeric_limits<int>::max();
+    int direction = 0;
+
+    for (auto move : getZeroMoves(blocks))
+    {
+        ++direction;
+
+        if (move.first < 0 || move.first >= side || move.second < 0 || move.second >= side)
+        {
+            continue;
+        }
+
+        if (direction == getOppositeDirection(previousDirection))
+        {
+            ++stats.duplicates;
+            continue;
+        }
+
+        ++stats.generated;
+
+        int delta = heuristic.getDelta(blocks, move.first * Side + move.second);
+        blocks.moveZero(move.first, move.second);
+        road.push_back(direction);
+
+        int result = idaSearch(blocks, estimate + delta, level + 1, bound, direction, road, heuristic, stats);
+
+        if (result == FOUND)
+        {
+            return FOUND;
+        }
+
+        minimum = std::min(minimum, result);
+
+        road.pop_back();
+        blocks.moveZero(zeroX, zeroY);
+    }
+
+    return minimum;
+}
+
+template <std::size_t Side>
+bool solveIda(Board<Side> blocks, std::vector<int>& road, const Heuristic<Side>& heuristic, SearchStats& stats)
+{
+    int estimate = heuristic.getDistance(blocks);
+    int bound = estimate;
+
+    while (true)
+    {
+        int result = idaSearch(blocks, estimate, 0, bound, 0, road, heuristic, stats);
+
+        if (result == FOUND)
+        {
+            return true;
+        }
+
+        if (result == std::numeric_limits<int>::max())
+        {
+            return false;
+        }
+
+        bound = result;
+    }
+}
+
+// A search node of the hash-distributed A*. Parents may live on another
+// worker, so they are referenced by worker and index in that worker's arena.
+const std::uint16_t NO_WORKER = 0xffff;
+
+template <std::size_t Side>
+struct DistributedNode
+{
+    Board<Side> blocks;
+    std::uint16_t estimate;
+    std::uint16_t level;
+    std::uint16_t parentWorker;
+    std::uint8_t direction;
+    std::uint32_t parentIndex;
+};
+
+// Hash-distributed A* (HDA*). Every state is owned by the worker its key
+// hashes to; only the owner keeps it in its open and closed lists. Generated
+// children are buffered per owner and handed over in batches through a
+// lock-free inbox (a stack of batches that the owner takes as a whole).
+//
+// The first goal found is only an upper bound. Workers keep expanding every
+// node cheaper than the best goal so far and the search ends when no worker
+// is active and no batch is in flight, which makes the result optimal.
+// "pending" counts active workers plus undelivered nodes; it reaches zero
+// exactly once, when all work is gone.
+template <std::size_t Side>
+class DistributedSearch
+{
+private:
+    static const std::size_t BATCH_SIZE = 64;
+    static const std::size_t FLUSH_INTERVAL = 32;
+
+    struct Batch
+    {
+        std::vector<DistributedNode<Side>> nodes;
+        Batch* next;
+    };
+
+    struct Worker
+    {
+        std::atomic<Batch*> inbox{nullptr};
+        std::vector<DistributedNode<Side>> arena;
+        std::unordered_map<BoardKey, std::uint32_t, BoardKeyHash> closed;
+        BucketQueue open;
+        std::vector<std::vector<DistributedNode<Side>>> outgoing;
+        SearchStats stats;
+    };
+
+    const Heuristic<Side>& heuristic;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::atomic<long> pending;
+    std::atomic<bool> done;
+    std::atomic<int> bestCost;
+    std::mutex bestMutex;
+    DistributedNode<Side> bestGoal;
+    SearchStats& stats;
+
+    // The closed map is estimated as its bucket array plus one allocated
+    // node (entry and next pointer) per state.
+    static std::size_t getMemoryBytes(const Worker& worker)
+    {
+        std::size_t bytes = worker.arena.capacity() * sizeof(DistributedNode<Side>) +
+                            worker.closed.bucket_count() * sizeof(void*) +
+                            worker.closed.size() * (sizeof(std::pair<const BoardKey, std::uint32_t>) + sizeof(void*)) +
+                            worker.open.getMemoryBytes();
+
+        for (const std::vector<DistributedNode<Side>>& batch : worker.outgoing)
+        {
+            bytes += batch.capacity() * sizeof(DistributedNode<Side>);
+        }
+
+        return bytes;
+    }
+
+    std::size_t getOwner(const BoardKey& key) const
+    {
+        return BoardKeyHash()(key) % this->workers.size();
+    }
+
+    void accept(Worker& worker, const DistributedNode<Side>& node)
+    {
+        if (node.level + node.estimate >= this->bestCost.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        BoardKey key = node.blocks.key();
+        auto found = worker.closed.find(key);
+
+        if (found == worker.closed.end())
+        {
+            worker.closed.emplace(key, worker.arena.size());
+            worker.arena.push_back(node);
+            worker.open.push(worker.arena.size() - 1, node.level + node.estimate, node.level);
+        }
+        else if (node.level < worker.arena[found->second].level)
+        {
+            // Reached again on a shorter path: reopen it.
+            worker.arena[found->second] = node;
+            worker.open.push(found->second, node.level + node.estimate, node.level);
+        }
+        else
+        {
+            ++worker.stats.duplicates;
+            return;
+        }
+
+        worker.stats.peakOpen = std::max(worker.stats.peakOpen, worker.open.size());
+    }
+
+    void receive(Worker& worker)
+    {
+        Batch* batch = worker.inbox.exchange(nullptr, std::memory_order_acquire);
+
+        while (batch)
+        {
+            for (const DistributedNode<Side>& node : batch->nodes)
+            {
+                accept(worker, node);
+            }
+
+            this->pending.fetch_sub(batch->nodes.size(), std::memory_order_acq_rel);
+
+            Batch* next = batch->next;
+            delete batch;
+            batch = next;
+        }
+    }
+
+    void send(std::size_t owner, std::vector<DistributedNode<Side>>& nodes)
+    {
+        Batch* batch = new Batch{std::move(nodes), nullptr};
+        nodes.clear();
+
+        this->pending.fetch_add(batch->nodes.size(), std::memory_order_acq_rel);
+
+        std::atomic<Batch*>& inbox = this->workers[owner]->inbox;
+        batch->next = inbox.load(std::memory_order_relaxed);
+        while (!inbox.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void flush(Worker& worker)
+    {
+        for (std::size_t owner = 0; owner < worker.outgoing.size(); ++owner)
+        {
+            if (!worker.outgoing[owner].empty())
+            {
+                send(owner, worker.outgoing[owner]);
+            }
+        }
+    }
+
+    void recordGoal(const DistributedNode<Side>& goal)
+    {
+        std::lock_guard<std::mutex> lock(this->bestMutex);
+
+        if (goal.level < this->bestCost.load(std::memory_order_relaxed))
+        {
+            this->stats.recordSolution();
+            this->bestGoal = goal;
+            this->bestCost.store(goal.level, std::memory_order_relaxed);
+        }
+    }
+
+    void expand(std::size_t workerIndex)
+    {
+        Worker& worker = *this->workers[workerIndex];
+        Node top = worker.open.pop();
+        DistributedNode<Side> current = worker.arena[top.index];
+        int cost = static_cast<int>(top.cost);
+
+        // Entries left behind by a reopened node are skipped.
+        if (current.level + current.estimate != cost || cost >= this->bestCost.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        ++worker.stats.expanded;
+
+        int direction = 0;
+
+        for (auto move : getZeroMoves(current.blocks))
+        {
+            ++direction;
+
+            DistributedNode<Side> child;
+
+            if (!createBlocksState(current.blocks, move.first, move.second, child.blocks))
+            {
+                continue;
+            }
+
+            ++worker.stats.generated;
+
+            child.estimate = current.estimate + this->heuristic.getDelta(current.blocks, move.first * Side + move.second);
+            child.level = current.level + 1;
+            child.parentWorker = workerIndex;
+            child.parentIndex = top.index;
+            child.direction = direction;
+
+            if (child.estimate == 0)
+            {
+                recordGoal(child);
+                continue;
+            }
+
+            std::size_t owner = getOwner(child.blocks.key());
+
+            if (owner == workerIndex)
+            {
+                accept(worker, child);
+            }
+            else
+            {
+                worker.outgoing[owner].push_back(child);
+                if (worker.outgoing[owner].size() >= BATCH_SIZE)
+                {
+                    send(owner, worker.outgoing[owner]);
+                }
+            }
+        }
+    }
+
+    void work(std::size_t workerIndex)
+    {
+        Worker& worker = *this->workers[workerIndex];
+        std::size_t expansions = 0;
+
+        while (!this->done.load(std::memory_order_acquire))
+        {
+            receive(worker);
+
+            if (!worker.open.empty() && static_cast<int>(worker.open.getMinCost()) < this->bestCost.load(std::memory_order_relaxed))
+            {
+                expand(workerIndex);
+
+                if (++expansions % FLUSH_INTERVAL == 0)
+                {
+                    flush(worker);
+                }
+
+                continue;
+            }
+
+            flush(worker);
+
+            if (this->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                this->done.store(true, std::memory_order_release);
+                break;
+            }
+
+            while (!this->done.load(std::memory_order_acquire))
+            {
+                if (worker.inbox.load(std::memory_order_acquire))
+                {
+                    this->pending.fetch_add(1, std::memory_order_acq_rel);
+                    break;
+                }
+
+                std::this_thread::yield();
+            }
+        }
+    }
+
+public:
+    DistributedSearch(const Heuristic<Side>& heuristic, std::size_t threadsCount, SearchStats& stats)
+        : heuristic(heuristic), pending(0), done(false), bestCost(std::numeric_limits<int>::max()), bestGoal{}, stats(stats)
+    {
+        threadsCount = std::min<std::size_t>(std::max<std::size_t>(threadsCount, 1), NO_WORKER);
+
+        for (std::size_t i = 0; i < threadsCount; ++i)
+        {
+            this->workers.push_back(std::make_unique<Worker>());
+            this->workers.back()->outgoing.resize(threadsCount);
+        }
+    }
+
+    DistributedSearch(const DistributedSearch&) = delete;
+    DistributedSearch& operator = (const DistributedSearch&) = delete;
+
+    ~DistributedSearch()
+    {
+        for (std::unique_ptr<Worker>& worker : this->workers)
+        {
+            Batch* batch = worker->inbox.exchange(nullptr);
+            while (batch)
+            {
+                Batch* next = batch->next;
+                delete batch;
+                batch = next;
+            }
+        }
+    }
+
+    bool solve(const Board<Side>& blocks, int estimate, std::vector<int>& road)
+    {
+        DistributedNode<Side> root{blocks, static_cast<std::uint16_t>(estimate), 0, NO_WORKER, 0, 0};
+        accept(*this->workers[getOwner(blocks.key())], root);
+
+        this->pending.store(this->workers.size());
+
+        std::vector<std::thread> threads;
+        for (std::size_t workerIndex = 0; workerIndex < this->workers.size(); ++workerIndex)
+        {
+            threads.emplace_back(&DistributedSearch::work, this, workerIndex);
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        // Per-worker peaks are summed, which bounds the peak of the total.
+        for (const std::unique_ptr<Worker>& worker : this->workers)
+        {
+            this->stats.expanded += worker->stats.expanded;
+            this->stats.generated += worker->stats.generated;
+            this->stats.duplicates += worker->stats.duplicates;
+            this->stats.peakOpen += worker->stats.peakOpen;
+            this->stats.peakClosed += worker->closed.size();
+            this->stats.memoryBytes += getMemoryBytes(*worker);
+        }
+
+        if (this->bestCost.load() == std::numeric_limits<int>::max())
+        {
+            return false;
+        }
+
+        // Parent links only ever point to strictly shorter paths, so the walk
+        // ends at the root.
+        road.clear();
+        DistributedNode<Side> node = this->bestGoal;
+        while (node.parentWorker != NO_WORKER)
+        {
+            road.push_back(node.direction);
+            node = this->workers[node.parentWorker]->arena[node.parentIndex];
+        }
+
+        std::reverse(road.begin(), road.end());
+
+        return true;
+    }
+};
+
+const char* getDirectionName(int direction)
+{
+    switch (direction)
+    {
+    case 1:
+        return "left";
+    case 2:
+        return "right";
+    case 3:
+        return "up";
+    case 4:
+        return "down";
+    default:
+        return "";
+    }
+}
+
+void printRoad(const std::vector<int>& road)
+{
+    std::cout << road.size() << std::endl;
+
+    for (int direction : road)
+    {
+        std::cout << getDirectionName(direction) << std::endl;
+    }
+}
+
+// Heuristics for one board size, keyed by the goal cell of the blank. The
+// pattern databases are mapped once and shared by every goal they match.
+// All tables are built by prepare() before the search starts and are only
+// read afterwards, so one cache can serve any number of worker threads.
+template <std::size_t Side>
+class HeuristicCache
+{
+private:
+    PatternDatabase<Side> patterns;
+    std::map<std::size_t, std::unique_ptr<Heuristic<Side>>> heuristics;
+
+public:
+    void prepare(std::size_t input_i, const std::string& patternsPath)
+    {
+        if (this->heuristics.count(input_i))
+        {
+            return;
+        }
+
+        std::vector<int> correctIndeces = getCorrectIndeces(Board<Side>::CELLS - 1, input_i);
+
+        if (!patternsPath.empty() && !this->patterns.isLoaded())
+        {
+            this->patterns.load(patternsPath, correctIndeces);
+        }
+
+        bool usePatterns = this->patterns.isLoaded() && this->patterns.matches(correctIndeces);
+        if (!patternsPath.empty() && !usePatterns)
+        {
+            std::cerr << patternsPath << " does not match the " << Side << "x" << Side << " goal with the blank at "
+                      << input_i << ", using the Manhattan distance" << std::endl;
+        }
+
+        this->heuristics[input_i] = std::make_unique<Heuristic<Side>>(correctIndeces, usePatterns ? &this->patterns : nullptr);
+    }
+
+    const Heuristic<Side>& get(std::size_t input_i) const
+    {
+        return *this->heuristics.at(input_i);
+    }
+};
+
+class SharedTables
+{
+private:
+    std::tuple<HeuristicCache<2>, HeuristicCache<3>, HeuristicCache<4>, HeuristicCache<5>> caches;
+
+public:
+    template <std::size_t Side>
+    HeuristicCache<Side>& get()
+    {
+        return std::get<Side - 2>(this->caches);
+    }
+
+    template <std::size_t Side>
+    const HeuristicCache<Side>& get() const
+    {
+        return std::get<Side - 2>(this->caches);
+    }
+};
+
+// Runs a fixed set of independent tasks. Every worker takes tasks from the
+// back of its own deque and, once that is empty, steals from the front of the
+// others'. Tasks never spawn new ones, so a worker that finds every deque
+// empty is done.
+class WorkStealingPool
+{
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    bool takeTask(std::size_t workerIndex, std::function<void()>& task)
+    {
+        Worker& own = *this->workers[workerIndex];
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+
+        for (std::size_t offset = 1; offset < this->workers.size(); ++offset)
+        {
+            Worker& victim = *this->workers[(workerIndex + offset) % this->workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+public:
+    explicit WorkStealingPool(std::size_t threadsCount)
+    {
+        for (std::size_t i = 0; i < std::max<std::size_t>(threadsCount, 1); ++i)
+        {
+            this->workers.push_back(std::make_unique<Worker>());
+        }
+    }
+
+    void run(std::vector<std::function<void()>>& tasks)
+    {
+        for (std::size_t i = 0; i < tasks.size(); ++i)
+        {
+            this->workers[i % this->workers.size()]->tasks.push_back(std::move(tasks[i]));
+        }
+
+        std::vector<std::thread> threads;
+        for (std::size_t workerIndex = 0; workerIndex < this->workers.size(); ++workerIndex)
+        {
+            threads.emplace_back([this, workerIndex]()
+            {
+                std::function<void()> task;
+                while (takeTask(workerIndex, task))
+                {
+                    task();
+                }
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+};
+
+enum class SearchMode
+{
+    A_STAR,
+    IDA_STAR,
+    HDA_STAR
+};
+
+struct Options
+{
+    SearchMode mode = SearchMode::A_STAR;
+    bool useHeap = false;
+    std::string patternsPath;
+    std::string generatePatternsPath;
+    std::string batchInputPath;
+    std::string batchOutputPath;
+    std::size_t threadsCount = std::thread::hardware_concurrency();
+    bool printStats = false;
+    bool benchmark = false;
+};
+
+struct Puzzle
+{
+    std::size_t side = 0;
+    std::size_t input_i = 0;
+    std::vector<std::vector<int>> blocks;
+    int zeroRowIndex = 0;
+};
+
+// Reads N, I and the board. Only N and I are read when readBlocks is false.
+// The board must hold every number from 0 to N exactly once.
+bool readPuzzle(std::istream& in, Puzzle& puzzle, bool readBlocks = true)
+{
+    std::size_t n;
+    int input_i;
+
+    if (!(in >> n >> input_i))
+    {
+        return false;
+    }
+
+    puzzle.side = std::sqrt(n + 1);
+    puzzle.input_i = (input_i == -1) ? n : input_i;
+
+    if (puzzle.side < 2 || puzzle.side > MAX_SIDE || puzzle.side * puzzle.side != n + 1 || puzzle.input_i > n)
+    {
+        return false;
+    }
+
+    if (!readBlocks)
+    {
+        return true;
+    }
+
+    puzzle.blocks.assign(puzzle.side, std::vector<int>(puzzle.side));
+    std::vector<bool> seen(n + 1, false);
+
+    for (std::size_t k = 0; k < puzzle.side; ++k)
+    {
+        for (std::size_t j = 0; j < puzzle.side; ++j)
+        {
+            int& block = puzzle.blocks[k][j];
+
+            if (!(in >> block) || block < 0 || static_cast<std::size_t>(block) > n || seen[block])
+            {
+                return false;
+            }
+
+            seen[block] = true;
+
+            if (block == 0)
+            {
+                puzzle.zeroRowIndex = k;
+            }
+        }
+    }
+
+    return true;
+}
+
+struct Solution
+{
+    bool solvable = false;
+    std::vector<int> road;
+    SearchStats stats;
+};
+
+template <std::size_t Side>
+int generatePatternDatabase(const std::string& path, const std::vector<int>& correctIndeces)
+{
+    if (getPatternSizes(Side).empty())
+    {
+        std::cerr << "There are no pattern databases for " << Side << "x" << Side << " boards" << std::endl;
+        return 1;
+    }
+
+    if (!PatternDatabase<Side>::generate(path, correctIndeces))
+    {
+        std::cerr << "Could not write " << path << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+template <std::size_t Side>
+void runSearch(const Puzzle& puzzle, const Heuristic<Side>& heuristic, const Options& options, Solution& result)
+{
+    Board<Side> board(puzzle.blocks);
+    int initialEstimate = heuristic.getDistance(board);
+
+    if (!isSolvable(puzzle.blocks, puzzle.zeroRowIndex))
+    {
+        return;
+    }
+
+    result.solvable = true;
+
+    if (initialEstimate == 0)
+    {
+        result.stats.recordSolution();
+        return;
+    }
+
+    if (options.mode == SearchMode::IDA_STAR)
+    {
+        // Only the path is kept; the recursion works on one board in place.
+        result.solvable = solveIda(board, result.road, heuristic, result.stats);
+        result.stats.memoryBytes = result.road.capacity() * sizeof(int);
+        return;
+    }
+
+    if (options.mode == SearchMode::HDA_STAR)
+    {
+        DistributedSearch<Side> search(heuristic, options.threadsCount, result.stats);
+        result.solvable = search.solve(board, initialEstimate, result.road);
+        return;
+    }
+
+    NodeArena<Side> arena;
+    arena.emplace_back(board, initialEstimate, 0);
+
+    ClosedSet visited;
+    std::uint32_t solution;
+
+    std::size_t queueBytes;
+
+    if (options.useHeap)
+    {
+        PriorityQueue queue(0, initialEstimate);
+        solution = solve(queue, visited, arena, heuristic, result.stats);
+        queueBytes = queue.getMemoryBytes();
+    }
+    else
+    {
+        BucketQueue queue(0, initialEstimate);
+        solution = solve(queue, visited, arena, heuristic, result.stats);
+        queueBytes = queue.getMemoryBytes();
+    }
+
+    result.stats.memoryBytes = arena.capacity() * sizeof(BlocksState<Side>) + visited.getMemoryBytes() + queueBytes;
+
+    if (solution == NO_PARENT)
+    {
+        result.solvable = false;
+        return;
+    }
+
+    result.road = getRoad(arena, solution);
+}
+
+template <std::size_t Side>
+Solution solvePuzzle(const Puzzle& puzzle, const Heuristic<Side>& heuristic, const Options& options)
+{
+    Solution result;
+
+    runSearch(puzzle, heuristic, options, result);
+    result.stats.seconds = result.stats.getElapsedSeconds();
+
+    return result;
+}
+
+template <std::size_t Side>
+Solution solvePuzzle(const Puzzle& puzzle, const SharedTables& tables, const Options& options)
+{
+    return solvePuzzle<Side>(puzzle, tables.get<Side>().get(puzzle.input_i), options);
+}
+
+Solution solvePuzzle(const Puzzle& puzzle, const SharedTables& tables, const Options& options)
+{
+    switch (puzzle.side)
+    {
+    case 2:
+        return solvePuzzle<2>(puzzle, tables, options);
+    case 3:
+        return solvePuzzle<3>(puzzle, tables, options);
+    case 4:
+        return solvePuzzle<4>(puzzle, tables, options);
+    default:
+        return solvePuzzle<5>(puzzle, tables, options);
+    }
+}
+
+void prepareTables(SharedTables& tables, const Puzzle& puzzle, const Options& options)
+{
+    switch (puzzle.side)
+    {
+    case 2:
+        tables.get<2>().prepare(puzzle.input_i, options.patternsPath);
+        break;
+    case 3:
+        tables.get<3>().prepare(puzzle.input_i, options.patternsPath);
+        break;
+    case 4:
+        tables.get<4>().prepare(puzzle.input_i, options.patternsPath);
+        break;
+    default:
+        tables.get<5>().prepare(puzzle.input_i, options.patternsPath);
+        break;
+    }
+}
+
+// Batch input has one puzzle per line: N, I and the N + 1 tiles row by row.
+// Each output line is the number of moves followed by the moves, -1 for an
+// unsolvable puzzle or "error" for a line that could not be read, in the
+// order of the input.
+int solveBatch(const Options& options)
+{
+    std::ifstream in(options.batchInputPath);
+    if (!in)
+    {
+        std::cerr << "Could not read " << options.batchInputPath << std::endl;
+        return 1;
+    }
+
+    std::vector<Puzzle> puzzles;
+    std::vector<bool> valid;
+    std::string line;
+
+    while (std::getline(in, line))
+    {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+        {
+            continue;
+        }
+
+        std::istringstream lineStream(line);
+        puzzles.emplace_back();
+        valid.push_back(readPuzzle(lineStream, puzzles.back()));
+    }
+
+    SharedTables tables;
+    for (std::size_t i = 0; i < puzzles.size(); ++i)
+    {
+        if (valid[i])
+        {
+            prepareTables(tables, puzzles[i], options);
+        }
+    }
+
+    std::vector<std::string> results(puzzles.size(), "error");
+    std::vector<std::function<void()>> tasks;
+
+    for (std::size_t i = 0; i < puzzles.size(); ++i)
+    {
+        if (!valid[i])
+        {
+            continue;
+        }
+
+        tasks.push_back([&puzzles, &results, &tables, &options, i]()
+        {
+            Solution solution = solvePuzzle(puzzles[i], tables, options);
+            std::string result = solution.solvable ? std::to_string(solution.road.size()) : "-1";
+
+            for (int direction : solution.road)
+            {
+                result += ' ';
+                result += getDirectionName(direction);
+            }
+
+            results[i] = std::move(result);
+        });
+    }
+
+    WorkStealingPool pool(options.threadsCount);
+    pool.run(tasks);
+
+    std::ofstream out(options.batchOutputPath);
+    for (const std::string& result : results)
+    {
+        out << result << '\n';
+    }
+
+    if (!out)
+    {
+        std::cerr << "Could not write " << options.batchOutputPath << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+void printStats(std::ostream& out, const SearchStats& stats)
+{
+    out << "expanded: " << stats.expanded << std::endl;
+    out << "generated: " << stats.generated << std::endl;
+    out << "duplicates: " << stats.duplicates << std::endl;
+    out << "peak open: " << stats.peakOpen << std::endl;
+    out << "peak closed: " << stats.peakClosed << std::endl;
+    out << "search memory: " << stats.memoryBytes / 1024 << " KB" << std::endl;
+    out << "process peak memory: " << getPeakMemory() << " KB" << std::endl;
+    out << "nodes per second: " << static_cast<std::uint64_t>(stats.getNodesPerSecond()) << std::endl;
+    out << "first solution: " << stats.firstSolutionSeconds << " s." << std::endl;
+    out << "duration: " << stats.seconds << " s." << std::endl;
+}
+
+struct BenchmarkSuite
+{
+    std::size_t side;
+    std::size_t instancesCount;
+    std::size_t walkLength;
+};
+
+// Random walks from the goal (blank last). Walks never undo their previous
+// step and use raw mt19937 output, so the instances are the same everywhere.
+const BenchmarkSuite BENCHMARK_SUITES[] = {
+    {3, 20, 200},
+    {4, 10, 120},
+    {5, 5, 50}
+};
+
+Puzzle makeBenchmarkPuzzle(std::size_t side, std::size_t walkLength, std::uint32_t seed)
+{
+    std::mt19937 gen(seed);
+
+    Puzzle puzzle;
+    puzzle.side = side;
+    puzzle.input_i = side * side - 1;
+    puzzle.blocks.assign(side, std::vector<int>(side));
+
+    for (std::size_t cell = 0; cell + 1 < side * side; ++cell)
+    {
+        puzzle.blocks[cell / side][cell % side] = cell + 1;
+    }
+
+    const int width = static_cast<int>(side);
+    int zeroX = width - 1;
+    int zeroY = width - 1;
+    int previousDirection = 0;
+
+    for (std::size_t step = 0; step < walkLength; ++step)
+    {
+        std::pair<int, int> moves[] = {
+            std::make_pair(zeroX, zeroY + 1),
+            std::make_pair(zeroX, zeroY - 1),
+            std::make_pair(zeroX + 1, zeroY),
+            std::make_pair(zeroX - 1, zeroY)
+        };
+        std::vector<int> directions;
+
+        for (int direction = 1; direction <= 4; ++direction)
+        {
+            std::pair<int, int> move = moves[direction - 1];
+            if (move.first >= 0 && move.first < width && move.second >= 0 && move.second < width &&
+                direction != getOppositeDirection(previousDirection))
+            {
+                directions.push_back(direction);
+            }
+        }
+
+        previousDirection = directions[gen() % directions.size()];
+        std::pair<int, int> move = moves[previousDirection - 1];
+
+        std::swap(puzzle.blocks[zeroX][zeroY], puzzle.blocks[move.first][move.second]);
+        zeroX = move.first;
+        zeroY = move.second;
+    }
+
+    puzzle.zeroRowIndex = zeroX;
+
+    return puzzle;
+}
+
+// Solves the fixed benchmark suite with the selected mode and writes one CSV
+// row per instance.
+int runBenchmark(const Options& options)
+{
+    std::cout << "size,instance,length,expanded,generated,duplicates,peak_open,peak_closed,"
+              << "seconds,nodes_per_second,first_solution_seconds,search_memory_kb" << std::endl;
+
+    SharedTables tables;
+
+    for (const BenchmarkSuite& suite : BENCHMARK_SUITES)
+    {
+        for (std::size_t instance = 0; instance < suite.instancesCount; ++instance)
+        {
+            Puzzle puzzle = makeBenchmarkPuzzle(suite.side, suite.walkLength, suite.side * 1000 + instance);
+            prepareTables(tables, puzzle, options);
+
+            Solution solution = solvePuzzle(puzzle, tables, options);
+            const SearchStats& stats = solution.stats;
+
+            std::cout << suite.side << "x" << suite.side << ',' << instance << ','
+                      << (solution.solvable ? static_cast<long>(solution.road.size()) : -1) << ','
+                      << stats.expanded << ',' << stats.generated << ',' << stats.duplicates << ','
+                      << stats.peakOpen << ',' << stats.peakClosed << ',' << stats.seconds << ','
+                      << static_cast<std::uint64_t>(stats.getNodesPerSecond()) << ','
+                      << stats.firstSolutionSeconds << ',' << stats.memoryBytes / 1024 << std::endl;
+        }
+    }
+
+    return 0;
+}
+
+// Parses a whole argument as a non-negative number.
+bool parseNumber(const std::string& text, std::size_t& value)
+{
+    const char* end = text.data() + text.size();
+    std::from_chars_result result = std::from_chars(text.data(), end, value);
+
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+// Usage: main [--ida | --hda | --heap] [--pdb FILE] [--threads K] [--stats]
+//        main [--ida | --hda | --heap] [--pdb FILE] --batch INPUT OUTPUT [--threads K]
+//        main [--ida | --hda | --heap] [--pdb FILE] --bench [--threads K]
+//        main --generate-pdb FILE    (reads only N and I from the input)
+//   --ida            use iterative-deepening A* instead of A* (memory linear in depth)
+//   --hda            use hash-distributed A* on K threads (optimal path)
+//   --heap           keep the A* open list in a binary heap ordered by f only
+//   --pdb FILE       use the pattern databases mapped from FILE as the heuristic
+//   --generate-pdb   build the pattern databases for the board size and goal and save them to FILE
+//   --batch          solve every puzzle of INPUT (one per line) on K threads and write the results to OUTPUT
+//   --stats          print the search counters to the standard error after the solution
+//   --bench          solve the built-in 3x3, 4x4 and 5x5 suite and print the counters as CSV
+int main (int argc, char* argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+
+        if (argument == "--ida")
+        {
+            options.mode = SearchMode::IDA_STAR;
+        }
+        else if (argument == "--hda")
+        {
+            options.mode = SearchMode::HDA_STAR;
+        }
+        else if (argument == "--heap")
+        {
+            options.useHeap = true;
+        }
+        else if (argument == "--pdb" && i + 1 < argc)
+        {
+            options.patternsPath = argv[++i];
+        }
+        else if (argument == "--generate-pdb" && i + 1 < argc)
+        {
+            options.generatePatternsPath = argv[++i];
+        }
+        else if (argument == "--batch" && i + 2 < argc)
+        {
+            options.batchInputPath = argv[++i];
+            options.batchOutputPath = argv[++i];
+        }
+        else if (argument == "--threads" && i + 1 < argc && parseNumber(argv[i + 1], options.threadsCount))
+        {
+            ++i;
+        }
+        else if (argument == "--stats")
+        {
+            options.printStats = true;
+        }
+        else if (argument == "--bench")
+        {
+            options.benchmark = true;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argument << std::endl;
+            return 1;
+        }
+    }
+
+    if (!options.batchInputPath.empty())
+    {
+        return solveBatch(options);
+    }
+
+    if (options.benchmark)
+    {
+        return runBenchmark(options);
+    }
+
+    Puzzle puzzle;
+    bool generating = !options.generatePatternsPath.empty();
+
+    if (!readPuzzle(std::cin, puzzle, !generating))
+    {
+        std::cerr << "Expected a board from 2x2 to " << MAX_SIDE << "x" << MAX_SIDE
+                  << " holding every number from 0 to N once" << std::endl;
+        return 1;
+    }
+
+    if (generating)
+    {
+        std::vector<int> correctIndeces = getCorrectIndeces(puzzle.side * puzzle.side - 1, puzzle.input_i);
 
-    delete initialState;
+        switch (puzzle.side)
+        {
+        case 3:
+            return generatePatternDatabase<3>(options.generatePatternsPath, correctIndeces);
+        case 4:
+            return generatePatternDatabase<4>(options.generatePatternsPath, correctIndeces);
+        case 5:
+            return generatePatternDatabase<5>(options.generatePatternsPath, correctIndeces);
+        default:
+            return generatePatternDatabase<2>(options.generatePatternsPath, correctIndeces);
+        }
+    }
+
+    SharedTables tables;
+    prepareTables(tables, puzzle, options);
+
+    Solution solution = solvePuzzle(puzzle, tables, options);
+
+    if (solution.solvable)
+    {
+        printRoad(solution.road);
+    }
+    else
+    {
+        std::cout << -1 << std::endl;
+    }
+
+    if (options.printStats)
+    {
+        printStats(std::cerr, solution.stats);
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -4,8 +4,19 @@
 #include <algorithm>
 #include <utility>
 #include <random>
+#include <string>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <system_error>
+#include <cstdlib>
 
-int swaps = 0;
+std::random_device rd;
 
 void print(const std::vector<int>& nQueens)
 {
@@ -23,183 +34,1075 @@ void print(const std::vector<int>& nQueens)
                 std::cout << " _ ";
             }
         }
-        std::cout << std::endl << std::endl; 
+        std::cout << "\n\n";
     }
 }
 
-std::vector<int> getKnightMoves(int row, int n) 
+enum class Initialisation
 {
-    std::vector<int> knightMoves = {2, -1};
-    std::vector<int> moves;
-    for (int move : knightMoves) 
-    {
-        int sum = move + row;
-        sum = (sum < 0) ? sum + n : sum;
-        moves.push_back(sum % n);
-    }
+    GREEDY,
+    KNIGHT
+};
+
+std::array<int, 2> getKnightMoves(int row, int n)
+{
+    std::array<int, 2> moves = {(row + 2) % n, (row - 1 + n) % n};
     return moves;
 }
 
-void initilise(std::vector<int>& nQueens)
+// Places each queen a knight move away from the previous one. When both rows
+// are taken the lowest free row is used instead.
+void initiliseKnight(std::vector<int>& nQueens)
 {
     int n = nQueens.size();
+    std::vector<bool> usedRows(n, false);
+    int lowestFreeRow = 0;
+
     nQueens[0] = 0;
+    usedRows[0] = true;
 
-    // std::cout << "New initialisation" << std::endl;
-    
     for (int col = 1; col < n; ++col)
     {
-        int prevQueenRow = nQueens[col - 1];
-        std::vector<int> knightRows = getKnightMoves(prevQueenRow, n);
-        std::vector<int> possibleRows;
-        for (int row : knightRows)
-        {
-            bool rowNotInBoard = true;
+        int row = -1;
 
-            for (int idx = 0; idx < col; ++idx)
+        for (int knightRow : getKnightMoves(nQueens[col - 1], n))
+        {
+            if (!usedRows[knightRow])
             {
-                if (row == nQueens[idx])
-                {
-                    rowNotInBoard = false;
-                    break;
-                }
+                row = knightRow;
+                break;
             }
+        }
 
-            if (rowNotInBoard)
+        if (row == -1)
+        {
+            while (usedRows[lowestFreeRow])
             {
-                possibleRows.push_back(row);
+                ++lowestFreeRow;
             }
+            row = lowestFreeRow;
         }
-        nQueens[col] = possibleRows[0];
+
+        nQueens[col] = row;
+        usedRows[row] = true;
     }
 }
 
-std::pair<int, int> mostConflictedQueen(int n,
-                                        const std::vector<int>& nQueens, 
-                                        const std::vector<int>& queensPerRow,
-                                        const std::vector<int>& queensPerD1,
-                                        const std::vector<int>& queensPerD2
-                                        )
+// Places the queens column by column on random free rows, taking the first
+// candidate whose diagonals are both empty, or the least attacked one after a
+// few tries. The free rows are the tail of nQueens itself, as in a
+// Fisher-Yates shuffle, so the result is a permutation, the whole pass is
+// O(n) and no pool needs allocating.
+void initiliseGreedy(std::vector<int>& nQueens, std::mt19937& gen)
 {
-    int maxConflicts = 0;
-    std::vector<int> possibleCols;
+    const int TRIES = 128;
+
+    int n = nQueens.size();
+    std::vector<bool> usedD1(2 * n - 1, false);
+    std::vector<bool> usedD2(2 * n - 1, false);
+
+    for (int row = 0; row < n; ++row)
+    {
+        nQueens[row] = row;
+    }
 
     for (int col = 0; col < n; ++col)
+    {
+        int bestIndex = col;
+        int bestConflicts = 3;
+
+        std::uniform_int_distribution<> distribution(col, n - 1);
+        for (int i = 0; i < TRIES && bestConflicts > 0; ++i)
+        {
+            int index = distribution(gen);
+            int row = nQueens[index];
+            int conflicts = usedD1[row - col + n - 1] + usedD2[row + col];
+
+            if (conflicts < bestConflicts)
+            {
+                bestConflicts = conflicts;
+                bestIndex = index;
+            }
+        }
+
+        std::swap(nQueens[col], nQueens[bestIndex]);
+
+        int row = nQueens[col];
+        usedD1[row - col + n - 1] = true;
+        usedD2[row + col] = true;
+    }
+}
+
+void initilise(std::vector<int>& nQueens, Initialisation initialisation, std::mt19937& gen)
+{
+    if (initialisation == Initialisation::KNIGHT)
+    {
+        initiliseKnight(nQueens);
+    }
+    else
+    {
+        initiliseGreedy(nQueens, gen);
+    }
+}
+
+// Queen counts for one family of diagonals, a byte per line. Lines almost
+// never hold more than a few queens; a count that reaches the byte's limit
+// keeps the excess in an overflow map.
+class DiagonalLines
+{
+private:
+    static const uint8_t MAX_COUNT = UINT8_MAX;
+
+    std::vector<uint8_t> lines;
+    std::unordered_map<int, int> overflow;
+
+public:
+    explicit DiagonalLines(int n)
+        : lines(2 * n - 1, 0) {}
+
+    void clear()
+    {
+        std::fill(lines.begin(), lines.end(), 0);
+        overflow.clear();
+    }
+
+    int getQueens(int line) const
+    {
+        if (lines[line] < MAX_COUNT)
+        {
+            return lines[line];
+        }
+
+        auto extra = overflow.find(line);
+        return MAX_COUNT + (extra == overflow.end() ? 0 : extra->second);
+    }
+
+    void add(int line)
+    {
+        if (lines[line] < MAX_COUNT)
+        {
+            ++lines[line];
+        }
+        else
+        {
+            ++overflow[line];
+        }
+    }
+
+    void remove(int line)
+    {
+        auto extra = (lines[line] < MAX_COUNT) ? overflow.end() : overflow.find(line);
+        if (extra == overflow.end())
+        {
+            --lines[line];
+        }
+        else if (--extra->second == 0)
+        {
+            overflow.erase(extra);
+        }
+    }
+};
+
+// Queen positions plus the counters of both diagonal families. Rows are
+// always a permutation, so they never conflict and need no counters.
+struct QueensBoard
+{
+    int n;
+    std::vector<int> nQueens;
+    DiagonalLines d1;
+    DiagonalLines d2;
+
+    explicit QueensBoard(int n)
+        : n(n), nQueens(n, -1), d1(n), d2(n) {}
+
+    int getD1(int row, int col) const
+    {
+        return row - col + n - 1;
+    }
+
+    int getD2(int row, int col) const
+    {
+        return row + col;
+    }
+
+    // Recounts the diagonals after nQueens was replaced, reusing the buffers.
+    void reset()
+    {
+        d1.clear();
+        d2.clear();
+
+        for (int col = 0; col < n; ++col)
+        {
+            int row = nQueens[col];
+
+            d1.add(getD1(row, col));
+            d2.add(getD2(row, col));
+        }
+    }
+
+    int getConflicts(int col) const
     {
         int row = nQueens[col];
 
-        int conflicts = queensPerD1[row - col + n - 1] + queensPerD2[row + col] + queensPerRow[row] - 3;
-        if (conflicts > maxConflicts)
+        return d1.getQueens(getD1(row, col)) + d2.getQueens(getD2(row, col)) - 2;
+    }
+};
+
+// Columns of queens known to be attacked, with O(1) insert and random pick.
+// A queen that moves onto an occupied diagonal is inserted, but the queen it
+// attacks there is not, since the counters cannot name it; solve rescans the
+// board whenever the set runs empty. Queens that stop being attacked are only
+// dropped when they are picked, so membership is a bit per column rather
+// than a position index.
+class ConflictSet
+{
+private:
+    std::vector<int> cols;
+    std::vector<bool> members;
+
+public:
+    explicit ConflictSet(int n)
+        : members(n, false) {}
+
+    bool empty() const
+    {
+        return cols.empty();
+    }
+
+    void clear()
+    {
+        for (int col : cols)
+        {
+            members[col] = false;
+        }
+        cols.clear();
+    }
+
+    void insert(int col)
+    {
+        if (!members[col])
+        {
+            members[col] = true;
+            cols.push_back(col);
+        }
+    }
+
+    int at(int index) const
+    {
+        return cols[index];
+    }
+
+    void removeAt(int index)
+    {
+        members[cols[index]] = false;
+        cols[index] = cols.back();
+        cols.pop_back();
+    }
+
+    int randomIndex(std::mt19937& gen) const
+    {
+        std::uniform_int_distribution<> distribution(0, cols.size() - 1);
+        return distribution(gen);
+    }
+};
+
+// Picks a random attacked queen from the set. Returns conflicts 0 when the
+// set has none left.
+std::pair<int, int> conflictedQueen(const QueensBoard& board, ConflictSet& conflicted, std::mt19937& gen)
+{
+    while (!conflicted.empty())
+    {
+        int index = conflicted.randomIndex(gen);
+        int col = conflicted.at(index);
+        int conflicts = board.getConflicts(col);
+
+        if (conflicts > 0)
         {
-            maxConflicts = conflicts;
-            possibleCols.clear();
-            possibleCols.push_back(col);
+            return std::make_pair(col, conflicts);
         }
-        else if (conflicts == maxConflicts)
+
+        conflicted.removeAt(index);
+    }
+
+    return std::make_pair(-1, 0);
+}
+
+// Inserts every attacked queen. Returns false if there is none, i.e. the
+// board is solved.
+bool collectConflicts(const QueensBoard& board, ConflictSet& conflicted)
+{
+    for (int col = 0; col < board.n; ++col)
+    {
+        if (board.getConflicts(col) > 0)
         {
-            possibleCols.push_back(col);
+            conflicted.insert(col);
         }
     }
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    return !conflicted.empty();
+}
 
-    std::uniform_int_distribution<> distribution(0, possibleCols.size() - 1);
-    int randomIndex = distribution(gen);
-    int randomElement = possibleCols[randomIndex];
+// The four diagonals the queens in columns first and second leave, and the
+// four they enter, when they swap rows.
+struct SwapLines
+{
+    DiagonalLines* families[4];
+    int oldLines[4];
+    int newLines[4];
 
-    return std::make_pair(randomElement, maxConflicts);
+    SwapLines(QueensBoard& board, int first, int second)
+        : families{&board.d1, &board.d2, &board.d1, &board.d2}
+    {
+        int firstRow = board.nQueens[first];
+        int secondRow = board.nQueens[second];
+
+        oldLines[0] = board.getD1(firstRow, first);
+        oldLines[1] = board.getD2(firstRow, first);
+        oldLines[2] = board.getD1(secondRow, second);
+        oldLines[3] = board.getD2(secondRow, second);
+
+        newLines[0] = board.getD1(secondRow, first);
+        newLines[1] = board.getD2(secondRow, first);
+        newLines[2] = board.getD1(firstRow, second);
+        newLines[3] = board.getD2(firstRow, second);
+    }
+};
+
+// Change in the number of attacking pairs if the queens in columns first and
+// second swapped rows. The counters are updated in place and restored, which
+// keeps the result exact when the four diagonals overlap.
+int getSwapDelta(QueensBoard& board, int first, int second)
+{
+    SwapLines swap(board, first, second);
+    int delta = 0;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        swap.families[i]->remove(swap.oldLines[i]);
+        delta -= swap.families[i]->getQueens(swap.oldLines[i]);
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        delta += swap.families[i]->getQueens(swap.newLines[i]);
+        swap.families[i]->add(swap.newLines[i]);
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        swap.families[i]->remove(swap.newLines[i]);
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        swap.families[i]->add(swap.oldLines[i]);
+    }
+
+    return delta;
 }
 
-void moveQueen(int n,
-               int col,
-               std::vector<int>& nQueens, 
-               std::vector<int>& queensPerRow,
-               std::vector<int>& queensPerD1,
-               std::vector<int>& queensPerD2)
+void swapQueens(QueensBoard& board, int first, int second, ConflictSet& conflicted)
 {
-    int minConflicts = n;
-    int minConflictsRow = 0;
+    SwapLines swap(board, first, second);
 
-    for (int row = 0; row < n; ++row)
+    for (int i = 0; i < 4; ++i)
+    {
+        swap.families[i]->remove(swap.oldLines[i]);
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        swap.families[i]->add(swap.newLines[i]);
+    }
+
+    std::swap(board.nQueens[first], board.nQueens[second]);
+
+    if (board.getConflicts(first) > 0)
+    {
+        conflicted.insert(first);
+    }
+    if (board.getConflicts(second) > 0)
+    {
+        conflicted.insert(second);
+    }
+}
+
+// Repairs an attacked queen by swapping rows with the best of a fixed number
+// of random columns, so a step costs the same for any n. Sideways swaps are
+// taken too, to walk across plateaus.
+void moveQueen(int col, QueensBoard& board, ConflictSet& conflicted, std::mt19937& gen)
+{
+    const int SAMPLES = 32;
+
+    std::uniform_int_distribution<> distribution(0, board.n - 1);
+    int bestDelta = 1;
+    int bestCol = -1;
+
+    for (int i = 0; i < SAMPLES; ++i)
     {
-        int conflicts = queensPerD1[row - col + n - 1] + queensPerD2[row + col] + queensPerRow[row];
+        int other = distribution(gen);
+        if (other == col)
+        {
+            continue;
+        }
 
-        if (conflicts < minConflicts)
+        int delta = getSwapDelta(board, col, other);
+        if (delta < bestDelta)
         {
-            minConflicts = conflicts;
-            minConflictsRow = row;
+            bestDelta = delta;
+            bestCol = other;
+
+            if (delta < 0)
+            {
+                break;
+            }
         }
     }
 
-    int row = nQueens[col];
+    if (bestCol != -1)
+    {
+        swapQueens(board, col, bestCol, conflicted);
+    }
+}
+
+// Repairs needed from a random permutation grow about linearly with n, so the
+// budget before a restart does too.
+int getIterationBudget(int n)
+{
+    return 100 + 4 * n;
+}
+
+// Everything one search mutates besides its board, so portfolio runs share
+// nothing.
+struct SolverRun
+{
+    Initialisation initialisation;
+    std::mt19937 gen;
+    long long swaps = 0;
+};
+
+// Restarts from a fresh greedy placement whenever the budget runs out. Only
+// the first attempt uses the run's initialisation. Returns an empty vector
+// once cancelled is set; it is polled every few thousand repairs.
+std::vector<int> solve(int n, int maxIterations, SolverRun& run, const std::atomic<bool>& cancelled)
+{
+    const int CANCEL_CHECK_INTERVAL = 4096;
 
-    --queensPerD1[row - col + n - 1];
-    --queensPerD2[row + col];
-    --queensPerRow[row];
-    ++queensPerD1[minConflictsRow - col + n - 1];
-    ++queensPerD2[minConflictsRow + col];
-    ++queensPerRow[minConflictsRow];
+    QueensBoard board(n);
+    ConflictSet conflicted(n);
+
+    initilise(board.nQueens, run.initialisation, run.gen);
+
+    while (!cancelled.load(std::memory_order_relaxed))
+    {
+        board.reset();
+        conflicted.clear();
+        collectConflicts(board, conflicted);
 
-    nQueens[col] = minConflictsRow;
+        for (int i = 0; i < maxIterations; ++i)
+        {
+            if (i % CANCEL_CHECK_INTERVAL == 0 && cancelled.load(std::memory_order_relaxed))
+            {
+                return std::vector<int>();
+            }
+
+            std::pair<int, int> pair = conflictedQueen(board, conflicted, run.gen);
+            int col = pair.first;
+            int conflicts = pair.second;
+
+            if (conflicts == 0)
+            {
+                if (!collectConflicts(board, conflicted))
+                {
+                    return std::move(board.nQueens);
+                }
+                continue;
+            }
+
+            ++run.swaps;
+
+            moveQueen(col, board, conflicted, run.gen);
+        }
+
+        initiliseGreedy(board.nQueens, run.gen);
+    }
+
+    return std::vector<int>();
 }
 
-std::vector<int> solve(int n, int maxIterations)
+struct PortfolioResult
+{
+    std::vector<int> nQueens;
+    int run;
+    long long swaps;
+};
+
+// Runs runsCount independent searches on threadsCount threads and keeps the
+// first solution. Run r is seeded from (seed, r); run 0 uses the requested
+// initialisation, run 1 the other one and the rest start greedy. The winner
+// sets the shared flag, which the other runs poll and give up on.
+PortfolioResult solvePortfolio(int n, Initialisation initialisation, unsigned int seed, int runsCount, int threadsCount)
 {
-    std::vector<int> nQueens(n, -1);
-    initilise(nQueens);
+    Initialisation other = (initialisation == Initialisation::GREEDY) ? Initialisation::KNIGHT : Initialisation::GREEDY;
+    int maxIterations = getIterationBudget(n);
 
-    std::vector<int> queensPerRow(n, 0);
-    std::vector<int> queensPerD1(2 * n - 1, 0);
-    std::vector<int> queensPerD2(2 * n - 1, 0);
+    std::atomic<bool> solved(false);
+    std::atomic<int> nextRun(0);
+    PortfolioResult result;
 
-    for (int col = 0; col < n; ++col)
+    auto worker = [&]()
     {
-        int row = nQueens[col];
+        int index;
+        while ((index = nextRun.fetch_add(1)) < runsCount && !solved.load())
+        {
+            std::seed_seq seq = {seed, static_cast<unsigned int>(index)};
+            SolverRun run;
+            run.initialisation = (index == 0) ? initialisation : (index == 1) ? other : Initialisation::GREEDY;
+            run.gen.seed(seq);
+
+            std::vector<int> nQueens = solve(n, maxIterations, run, solved);
+
+            bool expected = false;
+            if (!nQueens.empty() && solved.compare_exchange_strong(expected, true))
+            {
+                result.nQueens = std::move(nQueens);
+                result.run = index;
+                result.swaps = run.swaps;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadsCount; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
 
-        ++queensPerRow[row];
-        ++queensPerD1[row - col + n - 1];
-        ++queensPerD2[row + col];
+    return result;
+}
+
+// Counts the completions of a partial placement, one row per level. Columns
+// and both diagonal directions are bitmasks; the diagonals shift by one
+// column per row.
+uint64_t countCompletions(uint32_t all, uint32_t cols, uint32_t d1, uint32_t d2, uint64_t& nodes)
+{
+    if (cols == all)
+    {
+        return 1;
+    }
+
+    uint64_t count = 0;
+    uint32_t free = all & ~(cols | d1 | d2);
+
+    while (free != 0)
+    {
+        uint32_t bit = free & -free;
+        free ^= bit;
+
+        ++nodes;
+        count += countCompletions(all, cols | bit, (d1 | bit) << 1, (d2 | bit) >> 1, nodes);
+    }
+
+    return count;
+}
+
+struct CountResult
+{
+    uint64_t solutions;
+    uint64_t nodes;
+};
+
+// Counts all solutions on threadsCount threads. Mirroring a board left to
+// right maps solutions with the first queen in the left half onto those in
+// the right half, so only the left half is searched and doubled. For odd n
+// the first queen in the middle column is mirrored through the second
+// queen instead. Each task fixes the first two queens, and workers take the
+// next task from a shared index, so no thread idles while work is left.
+CountResult countSolutions(int n, int threadsCount)
+{
+    if (n == 1)
+    {
+        return CountResult{1, 1};
+    }
+
+    uint32_t all = (1u << n) - 1;
+    int middle = n / 2;
+    std::vector<std::pair<int, int>> tasks;
+
+    for (int first = 0; first < (n + 1) / 2; ++first)
+    {
+        for (int second = 0; second < (first == middle ? middle : n); ++second)
+        {
+            if (std::abs(second - first) > 1)
+            {
+                tasks.emplace_back(first, second);
+            }
+        }
+    }
+
+    std::atomic<int> nextTask(0);
+    std::atomic<uint64_t> solutions(0);
+    std::atomic<uint64_t> nodes(0);
+
+    auto worker = [&]()
+    {
+        uint64_t workerSolutions = 0;
+        uint64_t workerNodes = 0;
+        int index;
+
+        while ((index = nextTask.fetch_add(1)) < static_cast<int>(tasks.size()))
+        {
+            uint32_t first = 1u << tasks[index].first;
+            uint32_t second = 1u << tasks[index].second;
+
+            workerNodes += 2;
+            workerSolutions += countCompletions(all, first | second,
+                                                ((first << 1) | second) << 1,
+                                                ((first >> 1) | second) >> 1,
+                                                workerNodes);
+        }
+
+        solutions += workerSolutions;
+        nodes += workerNodes;
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadsCount; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    return CountResult{2 * solutions.load(), nodes.load()};
+}
+
+// Solution files hold n followed by the row of every column: decimal numbers
+// one per line for TEXT, uint32_t values in host byte order for BINARY.
+enum class OutputFormat
+{
+    TEXT,
+    BINARY
+};
+
+// Writes through a large buffer so huge boards do not pay per-value stream
+// overhead. Blocks bigger than the buffer go straight to the file. A short
+// write is remembered, so the caller can check good() once at the end.
+class BufferedWriter
+{
+private:
+    FILE* file;
+    std::vector<char> buffer;
+    size_t size = 0;
+    bool failed = false;
+
+public:
+    explicit BufferedWriter(FILE* file, size_t capacity = 1 << 20)
+        : file(file), buffer(capacity) {}
+
+    ~BufferedWriter()
+    {
+        flush();
+    }
+
+    void write(const void* data, size_t length)
+    {
+        if (size + length > buffer.size())
+        {
+            flush();
+        }
+
+        if (length > buffer.size())
+        {
+            failed |= fwrite(data, 1, length, file) != length;
+            return;
+        }
+
+        memcpy(buffer.data() + size, data, length);
+        size += length;
+    }
+
+    void writeLine(uint32_t value)
+    {
+        char digits[16];
+        char* end = std::to_chars(digits, digits + sizeof(digits) - 1, value).ptr;
+        *end++ = '\n';
+
+        write(digits, end - digits);
+    }
+
+    void flush()
+    {
+        failed |= fwrite(buffer.data(), 1, size, file) != size;
+        failed |= fflush(file) != 0;
+        size = 0;
+    }
+
+    bool good() const
+    {
+        return !failed;
+    }
+};
+
+class BufferedReader
+{
+private:
+    FILE* file;
+    std::vector<char> buffer;
+    size_t size = 0;
+    size_t position = 0;
+
+    int get()
+    {
+        if (position == size)
+        {
+            size = fread(buffer.data(), 1, buffer.size(), file);
+            position = 0;
+
+            if (size == 0)
+            {
+                return EOF;
+            }
+        }
+
+        return static_cast<unsigned char>(buffer[position++]);
+    }
+
+public:
+    explicit BufferedReader(FILE* file, size_t capacity = 1 << 20)
+        : file(file), buffer(capacity) {}
+
+    bool read(void* data, size_t length)
+    {
+        char* out = static_cast<char*>(data);
+
+        while (length > 0)
+        {
+            if (position == size)
+            {
+                size = fread(buffer.data(), 1, buffer.size(), file);
+                position = 0;
+
+                if (size == 0)
+                {
+                    return false;
+                }
+            }
+
+            size_t chunk = std::min(length, size - position);
+            memcpy(out, buffer.data() + position, chunk);
+            position += chunk;
+            out += chunk;
+            length -= chunk;
+        }
+
+        return true;
+    }
+
+    // Reads the next decimal number. Returns false at the end of the input or
+    // on anything that is not a number fitting in uint32_t.
+    bool readNumber(uint32_t& value)
+    {
+        int c = skipSpaces();
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+
+        uint64_t number = 0;
+        for (; c >= '0' && c <= '9'; c = get())
+        {
+            number = number * 10 + (c - '0');
+            if (number > UINT32_MAX)
+            {
+                return false;
+            }
+        }
+
+        value = number;
+        return c == EOF || isspace(c);
     }
 
-    for (int i = 0; i < maxIterations; ++i)
+    bool atEnd(OutputFormat format)
     {
-        std::pair<int, int> pair = mostConflictedQueen(n, nQueens, queensPerRow, queensPerD1, queensPerD2);
-        int col = pair.first;
-        int conflicts = pair.second;
+        return (format == OutputFormat::TEXT ? skipSpaces() : get()) == EOF;
+    }
 
-        if (conflicts == 0)
+private:
+    int skipSpaces()
+    {
+        int c = get();
+        while (c != EOF && isspace(c))
         {
-            return nQueens;
+            c = get();
         }
+        return c;
+    }
+};
 
-        ++swaps;
+// Returns false if any part of the solution could not be written.
+bool writeSolution(const std::vector<int>& nQueens, FILE* file, OutputFormat format)
+{
+    BufferedWriter writer(file);
+    uint32_t n = nQueens.size();
 
-        moveQueen(n, col, nQueens, queensPerRow, queensPerD1, queensPerD2);
+    if (format == OutputFormat::BINARY)
+    {
+        writer.write(&n, sizeof(n));
+        writer.write(nQueens.data(), n * sizeof(int));
+    }
+    else
+    {
+        writer.writeLine(n);
+        for (int row : nQueens)
+        {
+            writer.writeLine(row);
+        }
     }
 
-    return solve(n, maxIterations);
+    writer.flush();
+    return writer.good();
 }
 
-int main ()
+// Checks a solution file in O(n): every row in range and used once, and no
+// diagonal used twice. Returns an empty string when it is valid, the reason
+// otherwise.
+std::string verifySolution(FILE* file, OutputFormat format)
 {
+    BufferedReader reader(file);
+    bool binary = format == OutputFormat::BINARY;
+    uint32_t n;
+
+    if (!(binary ? reader.read(&n, sizeof(n)) : reader.readNumber(n)))
+    {
+        return "missing board size";
+    }
+
+    std::vector<bool> usedRows(n, false);
+    std::vector<bool> usedD1(2 * static_cast<size_t>(n), false);
+    std::vector<bool> usedD2(2 * static_cast<size_t>(n), false);
+
+    for (uint32_t col = 0; col < n; ++col)
+    {
+        uint32_t row;
+        if (!(binary ? reader.read(&row, sizeof(row)) : reader.readNumber(row)))
+        {
+            return "missing row for column " + std::to_string(col);
+        }
+        if (row >= n)
+        {
+            return "row out of range in column " + std::to_string(col);
+        }
+
+        size_t d1 = static_cast<size_t>(row) + n - 1 - col;
+        size_t d2 = static_cast<size_t>(row) + col;
+
+        if (usedRows[row] || usedD1[d1] || usedD2[d2])
+        {
+            return "queen in column " + std::to_string(col) + " is attacked";
+        }
+
+        usedRows[row] = true;
+        usedD1[d1] = true;
+        usedD2[d2] = true;
+    }
+
+    if (!reader.atEnd(format))
+    {
+        return "trailing data after " + std::to_string(n) + " rows";
+    }
+
+    return "";
+}
+
+FILE* openFile(const std::string& path, const char* mode)
+{
+    if (path == "-")
+    {
+        return (mode[0] == 'r') ? stdin : stdout;
+    }
+
+    return fopen(path.c_str(), mode);
+}
+
+// Parses a whole argument as a non-negative number.
+bool parseNumber(const std::string& text, unsigned int& value)
+{
+    const char* end = text.data() + text.size();
+    std::from_chars_result result = std::from_chars(text.data(), end, value);
+
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+// Usage: main [--knight] [--portfolio K] [--threads T] [--output FILE] [--binary] [seed] < n
+//        main --count [--threads T] < n
+//        main --verify FILE [--binary]
+//   --knight        start from the knight-move placement instead of the greedy one
+//   --portfolio K   race K differently seeded runs and keep the first solution
+//   --threads T     threads for the portfolio or the count (default: hardware concurrency)
+//   --output FILE   write the solution to FILE ("-" for stdout); the summary
+//                   then goes to stderr if FILE is stdout
+//   --binary        use the binary solution format instead of text
+//   --verify FILE   check a solution file ("-" for stdin) instead of solving
+//   --count         count all solutions by backtracking instead (n < 32)
+// Without a seed one is drawn from std::random_device; it is printed after
+// the board or with the timing so a run can be repeated.
+int main(int argc, char* argv[])
+{
+    Initialisation initialisation = Initialisation::GREEDY;
+    unsigned int seed = rd();
+    int runsCount = 1;
+    int threadsCount = std::max(1u, std::thread::hardware_concurrency());
+    OutputFormat format = OutputFormat::TEXT;
+    std::string outputPath;
+    std::string verifyPath;
+    bool counting = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        unsigned int number;
+
+        if (arg == "--knight")
+        {
+            initialisation = Initialisation::KNIGHT;
+        }
+        else if (arg == "--portfolio" && i + 1 < argc && parseNumber(argv[i + 1], number))
+        {
+            runsCount = std::max(1u, number);
+            ++i;
+        }
+        else if (arg == "--threads" && i + 1 < argc && parseNumber(argv[i + 1], number))
+        {
+            threadsCount = std::max(1u, number);
+            ++i;
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else if (arg == "--binary")
+        {
+            format = OutputFormat::BINARY;
+        }
+        else if (arg == "--verify" && i + 1 < argc)
+        {
+            verifyPath = argv[++i];
+        }
+        else if (arg == "--count")
+        {
+            counting = true;
+        }
+        else if (parseNumber(arg, number))
+        {
+            seed = number;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (!verifyPath.empty())
+    {
+        FILE* file = openFile(verifyPath, "rb");
+        if (file == nullptr)
+        {
+            std::cerr << "Cannot open " << verifyPath << std::endl;
+            return 1;
+        }
+
+        std::string error = verifySolution(file, format);
+        if (file != stdin)
+        {
+            fclose(file);
+        }
+
+        std::cout << (error.empty() ? "Valid" : "Invalid: " + error) << std::endl;
+        return error.empty() ? 0 : 1;
+    }
+
     int n;
     std::cin >> n;
 
+    if (counting)
+    {
+        if (n < 1 || n >= 32)
+        {
+            std::cerr << "Counting supports 1 <= n < 32" << std::endl;
+            return 1;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        CountResult result = countSolutions(n, threadsCount);
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        std::cout << "Solutions: " << result.solutions << std::endl;
+        std::cout << "Nodes: " << result.nodes << std::endl;
+        std::cout << "Nodes/s: " << static_cast<uint64_t>(result.nodes / std::max(seconds, 1e-9)) << std::endl;
+        std::cout << "Duration: " << seconds << " s." << std::endl;
+        return 0;
+    }
+
+    if (n == 2 || n == 3)
+    {
+        std::cout << "No solution" << std::endl;
+        return 0;
+    }
+
     auto start = std::chrono::high_resolution_clock::now();
-    std::vector<int> nQueens = solve(n, 100);
+    PortfolioResult result = solvePortfolio(n, initialisation, seed, runsCount, std::min(threadsCount, runsCount));
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
 
-    if (n <= 100)
+    if (!outputPath.empty())
     {
-        print(nQueens);
+        FILE* file = openFile(outputPath, "wb");
+        if (file == nullptr)
+        {
+            std::cerr << "Cannot open " << outputPath << std::endl;
+            return 1;
+        }
+
+        bool written = writeSolution(result.nQueens, file, format) && !ferror(file);
+        if (file != stdout)
+        {
+            written &= fclose(file) == 0;
+        }
+
+        if (!written)
+        {
+            std::cerr << "Cannot write " << outputPath << std::endl;
+            return 1;
+        }
+    }
+
+    std::ostream& summary = (outputPath == "-") ? std::cerr : std::cout;
+
+    if (n <= 100 && outputPath.empty())
+    {
+        print(result.nQueens);
+        std::cout << "Seed: " << seed << std::endl;
     }
     else
     {
-        std::cout << "Swaps: " << swaps << std::endl;
-        std::cout << "Duration: " << duration.count() / 1000.0 << " s." << std::endl;
+        summary << "Seed: " << seed << std::endl;
+        if (runsCount > 1)
+        {
+            summary << "Run: " << result.run << std::endl;
+        }
+        summary << "Swaps: " << result.swaps << std::endl;
+        summary << "Duration: " << duration.count() / 1000.0 << " s." << std::endl;
     }
 
     return 0;
-}
\ No newline at end of file
+}
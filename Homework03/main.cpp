@@ -1,18 +1,27 @@
 #include <iostream>
 #include <vector>
-#include <unordered_set>
 #include <random>
 #include <algorithm>
 #include <fstream>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <charconv>
+#include <system_error>
 
 std::ofstream out("res.txt");
 
 std::random_device rd;
-std::mt19937 gen(rd());
 int M, N;
 const double CROSSOVER_RATE = 0.53;
 const double MUTATION_RATE = 0.1;
 const double REPRODUCTION_RATE = 0.15;
+const int GENERATIONS = 10000;
 
 struct Item
 {
@@ -22,20 +31,104 @@ struct Item
 
 std::vector<Item> items;
 
+// Items with a value and no weight are always worth taking and items
+// without a value never are. Cross-multiplying value and weight is only a
+// strict weak ordering for the remaining ones, so these two kinds are ranked
+// separately.
+int getRatioClass(const Item& item)
+{
+    if (item.value == 0)
+    {
+        return 2;
+    }
+
+    return (item.weight == 0) ? 0 : 1;
+}
+
+// Orders items by value per weight, best first.
+bool hasBetterRatio(const Item& a, const Item& b)
+{
+    int classA = getRatioClass(a);
+    int classB = getRatioClass(b);
+
+    if (classA != classB)
+    {
+        return classA < classB;
+    }
+
+    return classA == 1 &&
+           static_cast<long long>(a.value) * b.weight > static_cast<long long>(b.value) * a.weight;
+}
+
+// Genomes are packed 64 items to a word. Bits past N in the last word are
+// always zero, which every operator below preserves.
+const int WORD_BITS = 64;
+int wordsCount;
+
+// Item values and weights as separate arrays padded to whole words, plus
+// the totals of every word, so fitness can work a word at a time.
+std::vector<int> itemValues;
+std::vector<int> itemWeights;
+std::vector<int> wordValues;
+std::vector<int> wordWeights;
+
+// Item indices by value per weight, best first, for the greedy repair.
+std::vector<int> ratioOrder;
+int minWeight;
+
+void prepareItems()
+{
+    wordsCount = (N + WORD_BITS - 1) / WORD_BITS;
+    itemValues.assign(wordsCount * WORD_BITS, 0);
+    itemWeights.assign(wordsCount * WORD_BITS, 0);
+    wordValues.assign(wordsCount, 0);
+    wordWeights.assign(wordsCount, 0);
+
+    for (int i = 0; i < N; ++i)
+    {
+        itemValues[i] = items[i].value;
+        itemWeights[i] = items[i].weight;
+        wordValues[i / WORD_BITS] += items[i].value;
+        wordWeights[i / WORD_BITS] += items[i].weight;
+    }
+
+    ratioOrder.resize(N);
+    std::iota(ratioOrder.begin(), ratioOrder.end(), 0);
+    std::sort(ratioOrder.begin(), ratioOrder.end(), [](int i, int j)
+    {
+        return hasBetterRatio(items[i], items[j]);
+    });
+
+    minWeight = items.empty() ? 0 : items[0].weight;
+    for (const Item& item : items)
+    {
+        minWeight = std::min(minWeight, item.weight);
+    }
+}
+
+uint64_t getTailMask()
+{
+    int tailBits = N % WORD_BITS;
+    return (tailBits == 0) ? UINT64_MAX : (uint64_t(1) << tailBits) - 1;
+}
+
+// value and weight are totals of the chosen items, cached by evaluate().
+// Anything that changes words (crossover, mutation) calls it again; plain
+// copies keep the cache.
 struct Individual
 {
-    std::vector<bool> bits;
+    std::vector<uint64_t> words;
+    int value = 0;
+    int weight = 0;
 
     struct HashFunction 
     {
         size_t operator()(const Individual& obj) const 
         {
             size_t hash = 0;
-            // Combine hash values of individual bools in the vector
-            for (const bool bit : obj.bits) 
+            for (const uint64_t word : obj.words) 
             {
-                // Update the hash value using bitwise operations
-                hash ^= std::hash<bool>{}(bit) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+                hash ^= std::hash<uint64_t>{}(word) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
             }
             return hash;
         }
@@ -43,7 +136,17 @@ struct Individual
 
     bool operator==(const Individual& other) const 
     {
-        return bits == other.bits;
+        return words == other.words;
+    }
+
+    bool get(int i) const
+    {
+        return (words[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+    }
+
+    void flip(int i)
+    {
+        words[i / WORD_BITS] ^= uint64_t(1) << (i % WORD_BITS);
     }
 
     bool operator<(const Individual& other) const 
@@ -53,119 +156,178 @@ struct Individual
 
     int fitness() const
     {
+        return (weight <= M) ? value : 0;
+    }
+
+    // Full and empty words use the precomputed totals, sparse ones walk
+    // their set bits and dense ones take a branchless masked pass over all
+    // 64 items, which the compiler vectorizes.
+    void evaluate()
+    {
+        const int SPARSE_BITS = 12;
+
         int sumValue = 0;
         int sumWeight = 0;
 
-        for (int i = 0; i < N; ++i)
+        for (int w = 0; w < wordsCount; ++w)
         {
-            sumValue += (items[i].value * bits[i]);
-            sumWeight += (items[i].weight * bits[i]);
+            uint64_t word = words[w];
+            int bitsCount = __builtin_popcountll(word);
+            const int* values = &itemValues[w * WORD_BITS];
+            const int* weights = &itemWeights[w * WORD_BITS];
+
+            if (bitsCount == WORD_BITS)
+            {
+                sumValue += wordValues[w];
+                sumWeight += wordWeights[w];
+            }
+            else if (bitsCount <= SPARSE_BITS)
+            {
+                for (; word != 0; word &= word - 1)
+                {
+                    int bit = __builtin_ctzll(word);
+                    sumValue += values[bit];
+                    sumWeight += weights[bit];
+                }
+            }
+            else
+            {
+                for (int bit = 0; bit < WORD_BITS; ++bit)
+                {
+                    int mask = -static_cast<int>((word >> bit) & 1);
+                    sumValue += values[bit] & mask;
+                    sumWeight += weights[bit] & mask;
+                }
+            }
         }
 
-        return (sumWeight <= M) ? sumValue : 0;
+        value = sumValue;
+        weight = sumWeight;
+    }
+
+    // Makes the individual feasible by dropping the items with the worst value
+    // per weight until it fits, then fills what is left greedily with the
+    // best ones. Needs an up-to-date evaluate().
+    void repair()
+    {
+        for (int i = N - 1; i >= 0 && weight > M; --i)
+        {
+            int item = ratioOrder[i];
+            if (get(item))
+            {
+                flip(item);
+                value -= items[item].value;
+                weight -= items[item].weight;
+            }
+        }
+
+        for (int i = 0; i < N && M - weight >= minWeight; ++i)
+        {
+            int item = ratioOrder[i];
+            if (!get(item) && weight + items[item].weight <= M)
+            {
+                flip(item);
+                value += items[item].value;
+                weight += items[item].weight;
+            }
+        }
     }
 
     std::string toString() const
     {
         std::string result = "";
         
-        for (auto el : this->bits)
+        for (int i = 0; i < N; ++i)
         {
-            result += (el ? '1' : '0');
+            result += (get(i) ? '1' : '0');
         }
         
         return result;
     }
 };
 
-std::vector<Individual> generateInitialPopulation() 
+// Seeds the population with the greedy solution and N - 1 randomized greedy
+// ones: a random subset of random density, repaired. The repair keeps the
+// best-ratio items of the subset and fills up greedily, so the seeds are all
+// feasible and good but differ in which items they start from.
+std::vector<Individual> generateInitialPopulation(std::mt19937& gen) 
 {
-    std::unordered_set<Individual, Individual::HashFunction> population;
-    std::uniform_int_distribution<int> dis(0, 1);
+    std::vector<Individual> population;
+    std::uniform_real_distribution<double> dis(0.0, 1.0);
+
+    Individual greedy = Individual{std::vector<uint64_t>(wordsCount, 0)};
+    greedy.repair();
+    population.push_back(greedy);
 
-    while (population.size() < N) 
+    while (population.size() < static_cast<size_t>(N)) 
     {
-        std::vector<bool> bits;
-        
+        Individual individual = Individual{std::vector<uint64_t>(wordsCount, 0)};
+        double density = dis(gen);
+
         for (int i = 0; i < N; ++i)
         {
-            bits.push_back(dis(gen));
+            if (dis(gen) < density)
+            {
+                individual.flip(i);
+            }
         }
 
-        Individual temp = Individual{bits};
-        population.insert(temp);
+        individual.evaluate();
+        individual.repair();
+        population.push_back(individual);
     }
 
-    return std::vector<Individual>(population.begin(), population.end());
+    return population;
 }
 
-// std::vector<Individual> generateInitialPopulation() 
-// {
-//     std::vector<Individual> population;
-
-//     // Sort items by value-to-weight ratio (descending order)
-//     std::vector<int> indices(N);
-//     std::iota(indices.begin(), indices.end(), 0);
-//     std::sort(indices.begin(), indices.end(), [&](int i, int j) {
-//         return static_cast<double>(items[i].value) / items[i].weight >
-//                static_cast<double>(items[j].value) / items[j].weight;
-//     });
-
-//     // Greedy selection of items for the knapsack
-//     for (int i = 0; i < N; ++i) 
-//     {
-//         int weight = 0;
-//         std::vector<bool> bits(N, false);
-
-//         for (int j = 0; j <= i; ++j) 
-//         {
-//             if (weight + items[indices[j]].weight <= M) {
-//                 weight += items[indices[j]].weight;
-//                 bits[indices[j]] = true;
-//             }
-//         }
-
-//         population.push_back(Individual{bits});
-//     }
-
-//     return population;
-// }
-
-std::vector<Individual> selection(const std::vector<Individual>& population, int tournamentSize = 3) 
+// Tournament selection of two parents. Returns their indices in population.
+std::pair<int, int> selection(const std::vector<Individual>& population, std::mt19937& gen, int tournamentSize = 3) 
 {
-    std::vector<Individual> parents;
+    std::uniform_int_distribution<int> dis(0, population.size() - 1);
+    int parents[2];
 
-    while (parents.size() < 2) 
+    for (int& parent : parents)
     {
-        std::vector<Individual> tournament;
-
-        // Randomly select individuals for the tournament
-        while (tournament.size() < tournamentSize) 
+        // Randomly select individuals for the tournament and keep the best
+        int best = dis(gen);
+        for (int i = 1; i < tournamentSize; ++i) 
         {
-            int index = rand() % population.size();
-            tournament.push_back(population[index]);
-        }
-
-        // Find the best individual in the tournament
-        Individual best = tournament[0];
-        for (int i = 1; i < tournament.size(); ++i) 
-        {
-            if (tournament[i].fitness() > best.fitness()) 
+            int index = dis(gen);
+            if (population[index].fitness() > population[best].fitness()) 
             {
-                best = tournament[i];
+                best = index;
             }
         }
 
-        parents.push_back(best);
+        parent = best;
     }
 
-    return parents;
+    return std::make_pair(parents[0], parents[1]);
 }
 
-std::vector<Individual> twoPointerCrossover(const std::vector<Individual>& parents)
+// Children take each word as (first & ~mask) | (second & mask) and the
+// reverse, so a mask bit set means the genes at that position are swapped.
+// The children are written in place and must not alias the parents.
+template <typename MaskFunction>
+void crossWithMask(const Individual& first, const Individual& second,
+                   Individual& child1, Individual& child2, MaskFunction getMask)
 {
-    std::vector<Individual> children;
+    for (int w = 0; w < wordsCount; ++w)
+    {
+        uint64_t mask = getMask(w);
+
+        child1.words[w] = (first.words[w] & ~mask) | (second.words[w] & mask);
+        child2.words[w] = (second.words[w] & ~mask) | (first.words[w] & mask);
+    }
 
+    child1.evaluate();
+    child1.repair();
+    child2.evaluate();
+    child2.repair();
+}
+
+void twoPointerCrossover(const Individual& first, const Individual& second, Individual& child1, Individual& child2, std::mt19937& gen)
+{
     std::uniform_int_distribution<int> dis(0, N - 1);
     int point1 = dis(gen);
     int point2 = dis(gen);
@@ -182,70 +344,48 @@ std::vector<Individual> twoPointerCrossover(const std::vector<Individual>& paren
         std::swap(point1, point2);
     }
 
-    std::vector<bool> child1, child2;
-
-    // Perform crossover for each parent
-    for (int i = 0; i < N; ++i)
+    // Swap the genes in [point1, point2]
+    crossWithMask(first, second, child1, child2, [point1, point2](int w)
     {
-        if (i >= point1 && i <= point2) 
-        {
-            child1.push_back(parents[1].bits[i]);
-            child2.push_back(parents[0].bits[i]);
-        } 
-        else 
+        int from = point1 - w * WORD_BITS;
+        int to = point2 - w * WORD_BITS;
+        if (to < 0 || from >= WORD_BITS)
         {
-            child1.push_back(parents[0].bits[i]);
-            child2.push_back(parents[1].bits[i]);
+            return uint64_t(0);
         }
-    }
 
-    children.push_back(Individual{child1});
-    children.push_back(Individual{child2});
+        from = std::max(from, 0);
+        to = std::min(to, WORD_BITS - 1);
 
-    return children;
+        uint64_t upTo = (to == WORD_BITS - 1) ? UINT64_MAX : (uint64_t(1) << (to + 1)) - 1;
+        return upTo & ~((uint64_t(1) << from) - 1);
+    });
 }
 
-std::vector<Individual> uniformCrossover(const std::vector<Individual>& parents)
+void uniformCrossover(const Individual& first, const Individual& second, Individual& child1, Individual& child2, std::mt19937& gen)
 {
-    std::vector<Individual> children;
-    std::uniform_real_distribution<double> dis(0.0, 1.0);
-
-    std::vector<bool> child1, child2;
+    std::uniform_int_distribution<uint64_t> dis;
 
-    for (int i = 0; i < N; ++i) 
+    crossWithMask(first, second, child1, child2, [&dis, &gen](int)
     {
-        if (dis(gen) < 0.5) 
-        { 
-            child1.push_back(parents[0].bits[i]);
-            child2.push_back(parents[1].bits[i]);
-        } 
-        else 
-        {
-            child1.push_back(parents[1].bits[i]);
-            child2.push_back(parents[0].bits[i]);
-        }
-    }
-
-    children.push_back(Individual{child1});
-    children.push_back(Individual{child2});
-
-    return children;
+        return dis(gen);
+    });
 }
 
+using Crossover = void (*)(const Individual&, const Individual&, Individual&, Individual&, std::mt19937&);
 
-void mutate(std::vector<Individual>& individuals)
+// Flips every gene with probability MUTATION_RATE by jumping straight to
+// the next flipped position, whose distance is geometrically distributed.
+void mutate(Individual& individual, std::mt19937& gen)
 {
-    std::uniform_real_distribution<double> dis(0.0, 1.0);
-    for (Individual& individual : individuals)
+    std::geometric_distribution<int> skip(MUTATION_RATE);
+
+    for (int i = skip(gen); i < N; i += skip(gen) + 1)
     {
-        for (int i = 0; i < N; ++i)
-        {
-            if (dis(gen) < MUTATION_RATE)
-            {
-                individual.bits[i] = !individual.bits[i];
-            }
-        }
+        individual.flip(i);
     }
+    individual.evaluate();
+    individual.repair();
 }
 
 bool compareIndividuals(const Individual& i1, const Individual& i2)
@@ -253,10 +393,16 @@ bool compareIndividuals(const Individual& i1, const Individual& i2)
     return (i1.fitness() > i2.fitness());
 }
 
-std::vector<Individual> nextGeneration(const std::vector<Individual>& population)
+// Breeds the slots [begin, end) of next from population. next must already
+// hold population.size() individuals of the right length; the slots are
+// overwritten in place. Pairs of children are written two slots at a time,
+// and spare takes the second child when only one slot is left.
+void nextGeneration(const std::vector<Individual>& population, std::vector<Individual>& next,
+                    int begin, int end, Individual& spare, std::mt19937& gen,
+                    Crossover crossover = uniformCrossover)
 {
-    std::vector<Individual> nextGeneration;
     std::uniform_real_distribution<double> dis(0.0, 1.0);
+    int filled = begin;
 
     // int numberOfElites = 2;
 
@@ -265,42 +411,56 @@ std::vector<Individual> nextGeneration(const std::vector<Individual>& population
 
     // nextGeneration.insert(nextGeneration.end(), sortedPopulation.begin(), sortedPopulation.begin() + numberOfElites);
 
-    while (nextGeneration.size() < population.size())
+    while (filled < end)
     {
-        std::vector<Individual> children;
+        std::pair<int, int> parents = selection(population, gen);
+        const Individual& first = population[parents.first];
+        const Individual& second = population[parents.second];
 
-        std::vector<Individual> parents = selection(population);
+        Individual& child1 = next[filled];
+        Individual& child2 = (filled + 1 < end) ? next[filled + 1] : spare;
 
         if (dis(gen) < REPRODUCTION_RATE)
         {
-            children = parents;
+            child1 = first;
+            child2 = second;
         }
         else
         {
-            if (dis(gen) < CROSSOVER_RATE)
+            // Without crossover there are no children and the slots stay free
+            if (dis(gen) >= CROSSOVER_RATE)
             {
-                children = uniformCrossover(parents);
+                continue;
             }
 
+            crossover(first, second, child1, child2, gen);
+
             if (dis(gen) < MUTATION_RATE)
             {
-                mutate(children);
+                mutate(child1, gen);
+                mutate(child2, gen);
             }
         }
 
-        
-        nextGeneration.insert(nextGeneration.end(), children.begin(), children.end());
+        filled += 2;
     }
+}
 
-    return std::vector<Individual>(nextGeneration.begin(), nextGeneration.begin() + population.size());
+void printMaxFitness(int maxFitness, int index)
+{
+    out << maxFitness << std::endl;
+    if (index % 1000 == 0)
+    {
+        std::cout << maxFitness << std::endl;
+    }
 }
 
-void printGeneration(const std::vector<Individual>& population, int index)
+int printGeneration(const std::vector<Individual>& population, int index)
 {
     double sumFitness = 0.0;
     int maxFitness = 0;
 
-    for (auto individual : population)
+    for (const Individual& individual : population)
     {
         int fitness = individual.fitness();
         //std::cout << individual.toString() << " " << fitness << std::endl;
@@ -311,27 +471,412 @@ void printGeneration(const std::vector<Individual>& population, int index)
     double averageFitness = sumFitness / population.size();
     // std::cout << "Average fitness: " << averageFitness << std::endl;
     //std::cout << "Max fitness: " << maxFitness << std::endl;
-    out << maxFitness << std::endl;
-    if (index % 1000 == 0)
+    printMaxFitness(maxFitness, index);
+    //std::cout << "-----------------------------------------------------" << std::endl;
+
+    return maxFitness;
+}
+
+// A reusable barrier for a fixed number of threads. The last thread to
+// arrive runs the completion step under the lock before releasing the rest.
+// Waiters watch the phase counter, so spurious wakeups and a fast thread
+// arriving at the next phase cannot release anyone early.
+class GenerationBarrier
+{
+private:
+    std::mutex mutex;
+    std::condition_variable released;
+    int expected;
+    int waiting = 0;
+    unsigned long long phase = 0;
+
+public:
+    explicit GenerationBarrier(int expected) : expected(expected) {}
+
+    template <typename Completion>
+    void arriveAndWait(Completion completion)
     {
-        std::cout << maxFitness << std::endl;
+        std::unique_lock<std::mutex> lock(mutex);
+        unsigned long long arrivedPhase = phase;
+
+        if (++waiting == expected)
+        {
+            completion();
+            waiting = 0;
+            ++phase;
+            released.notify_all();
+            return;
+        }
+
+        released.wait(lock, [&]() { return phase != arrivedPhase; });
     }
-    //std::cout << "-----------------------------------------------------" << std::endl;
+};
+
+// Breeds every generation on threadsCount persistent workers. Worker k fills
+// its own slice of the next population with its own generator seeded from
+// (seed, k), so a run depends only on the seed and the thread count.
+// The last worker to reach the barrier prints and swaps the populations.
+// Returns the best fitness seen.
+int solveKnapsack(unsigned int seed, int threadsCount)
+{
+    std::seed_seq initialSeed = {seed};
+    std::mt19937 gen(initialSeed);
+
+    std::vector<Individual> population = generateInitialPopulation(gen);
+    std::vector<Individual> next = population;
+    int size = population.size();
+    int generation = 0;
+
+    int best = printGeneration(population, generation);
+
+    GenerationBarrier sync(threadsCount);
+    auto finishGeneration = [&]()
+    {
+        std::swap(population, next);
+        ++generation;
+
+        if (generation < GENERATIONS)
+        {
+            best = std::max(best, printGeneration(population, generation));
+        }
+    };
+
+    auto worker = [&](int slice)
+    {
+        int begin = static_cast<long long>(size) * slice / threadsCount;
+        int end = static_cast<long long>(size) * (slice + 1) / threadsCount;
+        Individual spare = population[0];
+
+        std::seed_seq sliceSeed = {seed, static_cast<unsigned int>(slice) + 1};
+        std::mt19937 sliceGen(sliceSeed);
+
+        for (int i = 0; i + 1 < GENERATIONS; ++i)
+        {
+            nextGeneration(population, next, begin, end, spare, sliceGen);
+            sync.arriveAndWait(finishGeneration);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int slice = 1; slice < threadsCount; ++slice)
+    {
+        threads.emplace_back(worker, slice);
+    }
+    worker(0);
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    return best;
+}
+
+// A one-slot mailbox between neighbouring islands. The sender swaps in a
+// copy of its best individual, freeing one the receiver never took, and the
+// receiver swaps the slot with null. Ownership only ever moves through one
+// atomic exchange, so neither side waits for the other.
+class Mailbox
+{
+private:
+    std::atomic<Individual*> slot{nullptr};
+
+public:
+    ~Mailbox()
+    {
+        delete slot.load();
+    }
+
+    void send(const Individual& individual)
+    {
+        delete slot.exchange(new Individual(individual));
+    }
+
+    bool receive(Individual& individual)
+    {
+        Individual* received = slot.exchange(nullptr);
+        if (received == nullptr)
+        {
+            return false;
+        }
+
+        individual = *received;
+        delete received;
+        return true;
+    }
+};
+
+// Evolves islandsCount populations on their own threads. Even islands use
+// uniform crossover and odd ones two-point crossover. Every
+// migrationInterval generations each island mails its best individual to
+// the next one in a ring and replaces its worst with whatever arrived. The
+// printed maximum of a generation is the best over all islands. Returns
+// the best fitness seen.
+int solveIslands(unsigned int seed, int islandsCount, int migrationInterval)
+{
+    std::vector<Mailbox> mailboxes(islandsCount);
+    std::vector<std::vector<int>> maxFitness(islandsCount, std::vector<int>(GENERATIONS));
+
+    auto island = [&](int index)
+    {
+        std::seed_seq islandSeed = {seed, static_cast<unsigned int>(index) + 1};
+        std::mt19937 gen(islandSeed);
+        Crossover crossover = (index % 2 == 1 && N > 1) ? twoPointerCrossover : uniformCrossover;
+
+        std::vector<Individual> population = generateInitialPopulation(gen);
+        std::vector<Individual> next = population;
+        Individual spare = population[0];
+        int size = population.size();
+
+        for (int i = 0; i < GENERATIONS; ++i)
+        {
+            auto [worst, best] = std::minmax_element(population.begin(), population.end());
+            maxFitness[index][i] = best->fitness();
+
+            if (i + 1 == GENERATIONS)
+            {
+                break;
+            }
+
+            if (i > 0 && i % migrationInterval == 0)
+            {
+                mailboxes[(index + 1) % islandsCount].send(*best);
+                mailboxes[index].receive(*worst);
+            }
+
+            nextGeneration(population, next, 0, size, spare, gen, crossover);
+            std::swap(population, next);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int index = 1; index < islandsCount; ++index)
+    {
+        threads.emplace_back(island, index);
+    }
+    island(0);
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    int bestOverall = 0;
+    for (int i = 0; i < GENERATIONS; ++i)
+    {
+        int best = 0;
+        for (int index = 0; index < islandsCount; ++index)
+        {
+            best = std::max(best, maxFitness[index][i]);
+        }
+
+        printMaxFitness(best, i);
+        bestOverall = std::max(bestOverall, best);
+    }
+
+    return bestOverall;
 }
 
-void solveKnapsack()
+enum class ExactEngine
 {
-    std::vector<Individual> population = generateInitialPopulation();
+    NONE,
+    AUTO,
+    DP,
+    BRANCH_AND_BOUND
+};
 
-    for (int i = 0; i < 10000; ++i)
+// The DP is used when both rows fit comfortably in memory and the table
+// has few enough cells to fill in seconds.
+const int DP_MAX_CAPACITY = 1 << 24;
+const long long DP_MAX_CELLS = 10'000'000'000LL;
+
+// Classic 0/1 knapsack DP keeping only the previous and current rows. With
+// separate rows the inner loop has no loop-carried dependency, so it
+// vectorizes into packed max operations.
+long long solveDp()
+{
+    std::vector<long long> previous(M + 1, 0);
+    std::vector<long long> current(M + 1, 0);
+
+    for (const Item& item : items)
     {
-        printGeneration(population, i);
-        population = nextGeneration(population);
+        int weight = item.weight;
+        long long value = item.value;
+
+        if (weight > M)
+        {
+            continue;
+        }
+
+        std::copy(previous.begin(), previous.begin() + weight, current.begin());
+        for (int capacity = weight; capacity <= M; ++capacity)
+        {
+            current[capacity] = std::max(previous[capacity], previous[capacity - weight] + value);
+        }
+
+        std::swap(previous, current);
     }
+
+    return previous[M];
 }
 
-int main ()
+// Depth-first branch and bound over the items sorted by value per weight.
+// The bound of a node is its LP relaxation: the remaining items are taken
+// greedily and the first one that does not fit is taken fractionally.
+// Prefix sums find that item by binary search, so a bound costs O(log N).
+class BranchAndBound
 {
+private:
+    std::vector<Item> sorted;
+    std::vector<long long> prefixWeight;
+    std::vector<long long> prefixValue;
+    long long best = 0;
+
+    double getBound(int index, long long capacity, long long value) const
+    {
+        long long limit = prefixWeight[index] + capacity;
+        int last = std::upper_bound(prefixWeight.begin() + index, prefixWeight.end(), limit) - prefixWeight.begin() - 1;
+
+        double bound = value + (prefixValue[last] - prefixValue[index]);
+        if (last < static_cast<int>(sorted.size()))
+        {
+            bound += static_cast<double>(sorted[last].value) * (limit - prefixWeight[last]) / sorted[last].weight;
+        }
+
+        return bound;
+    }
+
+    void search(int index, long long capacity, long long value)
+    {
+        best = std::max(best, value);
+
+        if (index == static_cast<int>(sorted.size()) || getBound(index, capacity, value) < best + 1)
+        {
+            return;
+        }
+
+        if (sorted[index].weight <= capacity)
+        {
+            search(index + 1, capacity - sorted[index].weight, value + sorted[index].value);
+        }
+        search(index + 1, capacity, value);
+    }
+
+public:
+    BranchAndBound()
+    {
+        // Items without a value never raise the optimum
+        for (const Item& item : items)
+        {
+            if (item.weight <= M && item.value > 0)
+            {
+                sorted.push_back(item);
+            }
+        }
+
+        std::sort(sorted.begin(), sorted.end(), hasBetterRatio);
+
+        prefixWeight.assign(sorted.size() + 1, 0);
+        prefixValue.assign(sorted.size() + 1, 0);
+        for (size_t i = 0; i < sorted.size(); ++i)
+        {
+            prefixWeight[i + 1] = prefixWeight[i] + sorted[i].weight;
+            prefixValue[i + 1] = prefixValue[i] + sorted[i].value;
+        }
+    }
+
+    long long solve()
+    {
+        search(0, M, 0);
+        return best;
+    }
+};
+
+ExactEngine chooseExactEngine(ExactEngine engine)
+{
+    if (engine != ExactEngine::AUTO)
+    {
+        return engine;
+    }
+
+    bool dpFits = M < DP_MAX_CAPACITY && static_cast<long long>(N) * (M + 1) <= DP_MAX_CELLS;
+    return dpFits ? ExactEngine::DP : ExactEngine::BRANCH_AND_BOUND;
+}
+
+long long solveExact(ExactEngine engine)
+{
+    return (engine == ExactEngine::DP) ? solveDp() : BranchAndBound().solve();
+}
+
+// Parses a whole argument as a non-negative number.
+bool parseNumber(const std::string& text, unsigned int& value)
+{
+    const char* end = text.data() + text.size();
+    std::from_chars_result result = std::from_chars(text.data(), end, value);
+
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+// Usage: main [--threads T] [--islands K] [--migration G] [--exact [dp|bb]] [seed] < input
+//   --threads T     breed each generation on T threads
+//   --islands K     evolve K separate populations on K threads instead,
+//                   passing each one's best to the next every G generations
+//                   (--migration, default 50)
+//   --exact         also solve exactly before the GA, with the DP or branch
+//                   and bound picked by size unless named, and report the
+//                   GA's gap to the optimum
+// Without a seed one is drawn from std::random_device and printed first, so
+// a run can be repeated with the same seed and thread count.
+int main(int argc, char* argv[])
+{
+    unsigned int seed = rd();
+    int threadsCount = 1;
+    int islandsCount = 0;
+    int migrationInterval = 50;
+    ExactEngine exactEngine = ExactEngine::NONE;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        unsigned int number;
+
+        if (arg == "--threads" && i + 1 < argc && parseNumber(argv[i + 1], number))
+        {
+            threadsCount = std::max(1u, number);
+            ++i;
+        }
+        else if (arg == "--islands" && i + 1 < argc && parseNumber(argv[i + 1], number))
+        {
+            islandsCount = std::max(1u, number);
+            ++i;
+        }
+        else if (arg == "--exact")
+        {
+            exactEngine = ExactEngine::AUTO;
+
+            std::string engine = (i + 1 < argc) ? argv[i + 1] : "";
+            if (engine == "dp" || engine == "bb")
+            {
+                exactEngine = (engine == "dp") ? ExactEngine::DP : ExactEngine::BRANCH_AND_BOUND;
+                ++i;
+            }
+        }
+        else if (arg == "--migration" && i + 1 < argc && parseNumber(argv[i + 1], number))
+        {
+            migrationInterval = std::max(1u, number);
+            ++i;
+        }
+        else if (parseNumber(arg, number))
+        {
+            seed = number;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
     std::cin >> M >> N;
 
     for (int i = 0; i < N; ++i)
@@ -342,7 +887,32 @@ int main ()
         items.push_back(Item{weight, value});
     }
 
-    solveKnapsack();
+    prepareItems();
+
+    long long optimum = 0;
+    if (exactEngine != ExactEngine::NONE)
+    {
+        exactEngine = chooseExactEngine(exactEngine);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        optimum = solveExact(exactEngine);
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        std::cout << "Optimum: " << optimum << " ("
+                  << (exactEngine == ExactEngine::DP ? "dp" : "branch and bound") << ", "
+                  << duration.count() / 1000.0 << " s.)" << std::endl;
+    }
+
+    std::cout << "Seed: " << seed << std::endl;
+    int best = (islandsCount > 0) ? solveIslands(seed, islandsCount, migrationInterval)
+                                  : solveKnapsack(seed, threadsCount);
+
+    if (exactEngine != ExactEngine::NONE)
+    {
+        double gap = (optimum > 0) ? 100.0 * (optimum - best) / optimum : 0.0;
+        std::cout << "GA best: " << best << ", gap: " << gap << "%" << std::endl;
+    }
 
     return 0;
-}
\ No newline at end of file
+}